@@ -0,0 +1,121 @@
+#include "alt.hpp"
+#include "heap.hpp"
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+const double inf = std::numeric_limits<double>::infinity();
+
+}
+
+const char path::Landmarks::magic[8] = {'P', 'A', 'T', 'H', 'A', 'L', 'T', '2'};
+
+path::Landmarks::Landmarks() : n(0), m(0), sum(0) {}
+
+void path::Landmarks::sssp(const Graph &graph, const size_t &s, std::vector<double> &dist) {
+  dist.assign(graph.size(), inf);
+  IndexedHeap<double> Q(graph.size());
+  dist[s] = 0;
+  Q.push(s, 0);
+  while (!Q.empty()) {
+    size_t u = Q.pop();
+    for (const size_t v : graph.adj(u)) {
+      double d = dist[u] + graph.dist(u, v);
+      if (d >= dist[v]) continue;
+      dist[v] = d;
+      Q.push(v, d);
+    }
+  }
+}
+
+void path::Landmarks::build(const Graph &graph, const size_t &k) {
+  n = graph.size();
+  m = graph.edges();
+  sum = graph.checksum();
+  ids.clear();
+  
+  // nearest[u] is the distance from u to the closest landmark picked so far
+  std::vector<double> nearest(n, inf), dist;
+  std::vector<std::vector<double>> columns;
+  
+  // start from the vertex farthest away from vertex 0
+  size_t next = 0;
+  if (n > 0) {
+    sssp(graph, 0, dist);
+    for (size_t u = 0; u < n; ++u)
+      if (dist[u] != inf && dist[u] > dist[next]) next = u;
+  }
+  
+  while (ids.size() < std::min(k, n)) {
+    ids.push_back(next);
+    sssp(graph, next, dist);
+    for (size_t u = 0; u < n; ++u) nearest[u] = std::min(nearest[u], dist[u]);
+    columns.push_back(std::move(dist));
+    
+    next = std::max_element(nearest.begin(), nearest.end()) - nearest.begin();
+    if (nearest[next] == 0) break;
+  }
+  
+  table.resize(n * ids.size());
+  for (size_t u = 0; u < n; ++u) {
+    for (size_t i = 0; i < ids.size(); ++i)
+      table[u*ids.size() + i] = columns[i][u];
+  }
+}
+
+bool path::Landmarks::save(const std::string &filename) const {
+  std::ofstream out(filename, std::ios::binary);
+  uint64_t header[4] = {n, m, sum, ids.size()};
+  out.write(magic, sizeof(magic));
+  out.write(reinterpret_cast<const char *>(header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(ids.data()), ids.size() * sizeof(uint64_t));
+  out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(double));
+  return bool(out);
+}
+
+bool path::Landmarks::load(const std::string &filename, const Graph &graph) {
+  std::ifstream in(filename, std::ios::binary);
+  char buf[sizeof(magic)];
+  uint64_t header[4];
+  if (!in.read(buf, sizeof(buf)) || std::memcmp(buf, magic, sizeof(magic)) != 0) return false;
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(header))) return false;
+  if (header[0] != graph.size() || header[1] != graph.edges()) return false;
+  // a table of another graph of the same size is not a lower bound here
+  if (header[2] != graph.checksum() || header[3] > graph.size()) return false;
+  
+  std::vector<uint64_t> marks(header[3]);
+  std::vector<double> rows(header[0] * marks.size());
+  in.read(reinterpret_cast<char *>(marks.data()), marks.size() * sizeof(uint64_t));
+  in.read(reinterpret_cast<char *>(rows.data()), rows.size() * sizeof(double));
+  if (!in) return false;
+  for (const uint64_t &l : marks)
+    if (l >= header[0]) return false;
+  
+  n = header[0];
+  m = header[1];
+  sum = header[2];
+  ids.swap(marks);
+  table.swap(rows);
+  return true;
+}
+
+path::ALT::ALT(const Graph &graph, const Landmarks &landmarks) : ASTAR(graph), L(landmarks), goal(nullptr) {}
+
+double path::ALT::h(const size_t &u, const size_t &g) {
+  double best = dist(u, g);
+  const double *from = L.row(u);
+  for (size_t i = 0; i < L.size(); ++i) {
+    // a landmark that cannot reach both vertices gives no bound
+    if (from[i] == inf || goal[i] == inf) continue;
+    best = std::max(best, std::abs(from[i] - goal[i]));
+  }
+  return best;
+}
+
+void path::ALT::find(const size_t &s, const size_t &g, Path &path) {
+  goal = L.row(g);
+  ASTAR::find(s, g, path);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "path.hpp"
+
+#ifndef alt_hpp
+#define alt_hpp
+
+namespace path {
+
+// shortest-path distances from k landmark vertices to every vertex
+//
+// landmarks are picked by farthest-point selection, each new landmark is the
+// vertex farthest from the ones already picked, unreachable vertices first
+class Landmarks {
+private:
+  static const char magic[8];
+  
+  // size and checksum of the graph the table was built for
+  size_t n, m;
+  uint64_t sum;
+  std::vector<uint64_t> ids;
+  // vertex-major, table[u*k + i] is the distance from landmark i to u
+  std::vector<double> table;
+  
+  static void sssp(const Graph &graph, const size_t &s, std::vector<double> &dist);
+  
+public:
+  Landmarks();
+  
+  void build(const Graph &graph, const size_t &k);
+  
+  bool save(const std::string &filename) const;
+  
+  // returns false if the file is missing or was built for another graph
+  bool load(const std::string &filename, const Graph &graph);
+  
+  size_t size() const { return ids.size(); }
+  
+  const double *row(const size_t &u) const { return table.data() + u*ids.size(); }
+};
+
+// A* with the triangle-inequality bound max_i |d(l_i, u) - d(l_i, g)|,
+// combined with the straight-line distance
+class ALT : public ASTAR {
+private:
+  const Landmarks &L;
+  const double *goal;
+  
+protected:
+  double h(const size_t &u, const size_t &g) override;
+  
+public:
+  ALT(const Graph &graph, const Landmarks &landmarks);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+}
+
+#endif /* alt_hpp */
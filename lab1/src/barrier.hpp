@@ -0,0 +1,37 @@
+#pragma once
+#include <mutex>
+#include <condition_variable>
+
+#ifndef barrier_hpp
+#define barrier_hpp
+
+namespace path {
+
+// reusable rendezvous point for a fixed team of threads
+class Barrier {
+private:
+  std::mutex mtx;
+  std::condition_variable cv;
+  const unsigned count;
+  unsigned waiting;
+  unsigned generation;
+  
+public:
+  Barrier(const unsigned &count) : count(count), waiting(0), generation(0) {}
+  
+  void wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    unsigned gen = generation;
+    if (++waiting == count) {
+      waiting = 0;
+      ++generation;
+      cv.notify_all();
+      return;
+    }
+    cv.wait(lock, [&] { return gen != generation; });
+  }
+};
+
+}
+
+#endif /* barrier_hpp */
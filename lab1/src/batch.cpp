@@ -0,0 +1,67 @@
+#include "batch.hpp"
+#include "tracing.hpp"
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+void path::batch(const Graph &graph, const Queries &queries, const SearchFactory &make, const unsigned &threads, const Report &report) {
+  // the graph is only read by the tracer, which may be compiled out
+  (void)graph;
+  const size_t n = queries.size();
+  std::vector<Path> results(n);
+  std::vector<Stats> costs(n);
+  std::vector<bool> ready(n);
+  std::atomic<size_t> next(0);
+  std::mutex mtx;
+  size_t flushed = 0;
+  
+  auto worker = [&]() {
+    std::unique_ptr<PathSearch> ps(make());
+    size_t i;
+    while ((i = next.fetch_add(1)) < n) {
+      PATH_TRACE(tracer.query(graph, queries[i].first, queries[i].second));
+      stats.clear();
+      Stopwatch watch;
+      ps->find(queries[i].first, queries[i].second, results[i]);
+      stats.seconds = watch.lap();
+      costs[i] = stats;
+      
+      // whoever completes the oldest pending query reports the finished prefix
+      std::lock_guard<std::mutex> lock(mtx);
+      ready[i] = true;
+      while (flushed < n && ready[flushed]) {
+        report(flushed, results[flushed], costs[flushed]);
+        Path().swap(results[flushed]);
+        ++flushed;
+      }
+    }
+  };
+  
+  std::vector<std::thread> team;
+  for (unsigned t = 1; t < std::min<size_t>(threads, n); ++t)
+    team.emplace_back(worker);
+  worker();
+  for (auto &th : team) th.join();
+}
+
+void path::matrix(const Graph &graph, const std::vector<size_t> &sources, const std::vector<size_t> &targets, const unsigned &threads, std::vector<double> &table) {
+  const size_t rows = sources.size(), cols = targets.size();
+  table.assign(rows * cols, 0);
+  std::atomic<size_t> next(0);
+  
+  // rows are disjoint, the workers write them without locking
+  auto worker = [&]() {
+    DIJKSTRA search(graph);
+    size_t i;
+    while ((i = next.fetch_add(1)) < rows)
+      search.distances(sources[i], targets, table.data() + i*cols);
+  };
+  
+  std::vector<std::thread> team;
+  for (unsigned t = 1; t < std::min<size_t>(threads, rows); ++t)
+    team.emplace_back(worker);
+  worker();
+  for (auto &th : team) th.join();
+}
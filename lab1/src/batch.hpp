@@ -0,0 +1,24 @@
+#pragma once
+#include "path.hpp"
+#include "stats.hpp"
+#include <functional>
+
+#ifndef batch_hpp
+#define batch_hpp
+
+namespace path {
+
+typedef std::function<PathSearch *()> SearchFactory;
+typedef std::function<void(const size_t &, const Path &, const Stats &)> Report;
+
+// answer every query on a team of threads, each with its own search instance
+// made by `make`, results are reported one at a time in input order
+void batch(const Graph &graph, const Queries &queries, const SearchFactory &make, const unsigned &threads, const Report &report);
+
+// cost from every source to every target into a row-major table, one
+// multi-target Dijkstra per source, the rows are spread over the threads
+void matrix(const Graph &graph, const std::vector<size_t> &sources, const std::vector<size_t> &targets, const unsigned &threads, std::vector<double> &table);
+
+}
+
+#endif /* batch_hpp */
@@ -0,0 +1,95 @@
+#include "cache.hpp"
+#include <algorithm>
+
+// constructors & destructors
+
+path::PathCache::PathCache(const size_t &entries, const size_t &stripes)
+  : count(std::max<size_t>(1, std::min(stripes, entries))), shards(new Shard[count]), hit(0), miss(0) {
+  // the entries are split exactly, the first shards take one of the remainder
+  for (size_t i = 0; i < count; ++i)
+    shards[i].capacity = std::max<size_t>(1, entries / count + (i < entries % count));
+}
+
+path::CachedSearch::CachedSearch(const Graph &graph, PathSearch *search, PathCache &cache, const std::string &alg)
+  : PathSearch(graph), search(search), cache(cache), alg(cache.id(alg)) {}
+
+// path cache
+
+size_t path::PathCache::Hash::operator()(const Key &k) const {
+  // splitmix64 finalizer over the packed pair, the algorithm id is mixed in last
+  uint64_t x = (uint64_t(k.s) << 32 | k.g) + 0x9e3779b97f4a7c15ULL * (k.alg + 1);
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+path::PathCache::Shard &path::PathCache::shard(const Key &key) const {
+  // the map of a shard uses the low bits, pick the shard from the high ones
+  return shards[(Hash()(key) >> 40) % count];
+}
+
+uint32_t path::PathCache::id(const std::string &alg) {
+  std::lock_guard<std::mutex> lock(names_mtx);
+  auto it = std::find(names.begin(), names.end(), alg);
+  if (it != names.end()) return it - names.begin();
+  names.push_back(alg);
+  return names.size() - 1;
+}
+
+bool path::PathCache::find(const uint32_t &alg, const size_t &s, const size_t &g, const uint64_t &generation, Path &path) {
+  Key key = {alg, uint32_t(s), uint32_t(g)};
+  Shard &sh = shard(key);
+  std::lock_guard<std::mutex> lock(sh.mtx);
+  
+  auto it = sh.index.find(key);
+  if (it == sh.index.end() || it->second->generation != generation) {
+    ++miss;
+    return false;
+  }
+  sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+  path.assign(it->second->path.begin(), it->second->path.end());
+  ++hit;
+  return true;
+}
+
+void path::PathCache::insert(const uint32_t &alg, const size_t &s, const size_t &g, const uint64_t &generation, const Path &path) {
+  Key key = {alg, uint32_t(s), uint32_t(g)};
+  Shard &sh = shard(key);
+  std::lock_guard<std::mutex> lock(sh.mtx);
+  
+  auto it = sh.index.find(key);
+  if (it != sh.index.end()) {
+    // another thread solved the same pair first, or the entry is stale
+    sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+  }
+  else {
+    if (sh.index.size() >= sh.capacity) {
+      sh.index.erase(sh.lru.back().key);
+      sh.lru.pop_back();
+    }
+    sh.lru.push_front(Entry());
+    sh.index[key] = sh.lru.begin();
+  }
+  Entry &e = sh.lru.front();
+  e.key = key;
+  e.generation = generation;
+  e.path.assign(path.begin(), path.end());
+}
+
+void path::PathCache::clear() {
+  for (size_t i = 0; i < count; ++i) {
+    std::lock_guard<std::mutex> lock(shards[i].mtx);
+    shards[i].lru.clear();
+    shards[i].index.clear();
+  }
+  hit = miss = 0;
+}
+
+// cached search
+
+void path::CachedSearch::find(const size_t &s, const size_t &g, Path &path) {
+  uint64_t generation = G.generation();
+  if (cache.find(alg, s, g, generation, path)) return;
+  search->find(s, g, path);
+  cache.insert(alg, s, g, generation, path);
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "path.hpp"
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#ifndef cache_hpp
+#define cache_hpp
+
+namespace path {
+
+// bounded map from (algorithm, start, goal) to the solution, least recently
+// used entries are evicted first
+//
+// the keys are spread over independently locked shards, so threads asking for
+// different pairs rarely wait on each other. Every entry remembers the graph
+// generation it was computed for and reads as a miss once the graph changed
+class PathCache {
+private:
+  struct Key {
+    uint32_t alg, s, g;
+    bool operator==(const Key &k) const { return alg == k.alg && s == k.s && g == k.g; }
+  };
+  
+  struct Hash {
+    size_t operator()(const Key &k) const;
+  };
+  
+  // vertex indices fit in 32 bits like the adjacency of the graph
+  struct Entry {
+    Key key;
+    uint64_t generation;
+    std::vector<uint32_t> path;
+  };
+  
+  struct Shard {
+    std::mutex mtx;
+    size_t capacity;
+    std::list<Entry> lru;  // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, Hash> index;
+  };
+  
+  const size_t count;  // never more shards than entries
+  std::unique_ptr<Shard[]> shards;
+  std::atomic<uint64_t> hit, miss;
+  
+  std::mutex names_mtx;
+  std::vector<std::string> names;
+  
+  Shard &shard(const Key &key) const;
+  
+public:
+  // at most `entries` solutions in total
+  PathCache(const size_t &entries, const size_t &stripes = 16);
+  
+  // small number standing for an algorithm name in the keys
+  uint32_t id(const std::string &alg);
+  
+  // copies the cached solution of the pair into `path`, false on a miss
+  bool find(const uint32_t &alg, const size_t &s, const size_t &g, const uint64_t &generation, Path &path);
+  
+  void insert(const uint32_t &alg, const size_t &s, const size_t &g, const uint64_t &generation, const Path &path);
+  
+  void clear();
+  
+  uint64_t hits() const { return hit; }
+  
+  uint64_t misses() const { return miss; }
+};
+
+// answers from the cache when it can and runs `search` otherwise, owns the
+// search it wraps
+class CachedSearch : public PathSearch {
+private:
+  std::unique_ptr<PathSearch> search;
+  PathCache &cache;
+  const uint32_t alg;
+  
+public:
+  CachedSearch(const Graph &graph, PathSearch *search, PathCache &cache, const std::string &alg);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+}
+
+#endif /* cache_hpp */
@@ -0,0 +1,330 @@
+#include "ch.hpp"
+#include "heap.hpp"
+#include "tracing.hpp"
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+const double inf = std::numeric_limits<double>::infinity();
+
+// witness searches give up after settling this many vertices, a missed
+// witness only costs an unnecessary shortcut, priorities are only estimates
+// so their simulated contractions get a much smaller budget
+const size_t settle_limit = 500, simulate_limit = 20;
+
+typedef path::Hierarchy::Arc Arc;
+
+class Contractor {
+private:
+  // links from every uncontracted vertex to its uncontracted neighbours
+  std::vector<std::vector<Arc>> links;
+  std::vector<uint32_t> deleted;
+  path::StampedArray<double> cost;
+  path::StampedSet targets;
+  path::IndexedHeap<double> Q;
+  
+  void witness(const size_t &source, const size_t &skip, const double &limit, size_t remaining, const size_t &budget);
+  
+  void link(const size_t &u, const size_t &w, const size_t &middle, const double &c);
+  
+  void unlink(const size_t &u, const size_t &v);
+  
+public:
+  Contractor(const path::Graph &graph);
+  
+  // shortcuts needed to contract v, written to out unless it is null
+  size_t shortcuts(const size_t &v, std::vector<std::pair<std::pair<size_t, size_t>, double>> *out);
+  
+  // weighted edge difference plus the contracted neighbours, the latter
+  // spreads contraction evenly over the graph
+  int priority(const size_t &v);
+  
+  // removes v from the graph and returns its links to higher vertices
+  std::vector<Arc> contract(const size_t &v);
+};
+
+Contractor::Contractor(const path::Graph &graph) : links(graph.size()), deleted(graph.size()), Q(graph.size()) {
+  for (size_t u = 0; u < graph.size(); ++u) {
+    for (const size_t v : graph.adj(u)) {
+      if (u != v) links[u].push_back({uint32_t(v), path::Hierarchy::none, graph.dist(u, v)});
+    }
+  }
+}
+
+// Dijkstra from source that avoids skip, it stops past limit or once all
+// `remaining` vertices in targets are settled
+void Contractor::witness(const size_t &source, const size_t &skip, const double &limit, size_t remaining, const size_t &budget) {
+  cost.reset(links.size(), inf);
+  Q.clear();
+  cost.set(source, 0);
+  Q.push(source, 0);
+  
+  size_t settled = 0;
+  while (!Q.empty() && Q.top_key() <= limit && settled++ < budget) {
+    size_t u = Q.pop();
+    if (targets.contains(u) && --remaining == 0) break;
+    for (const Arc &a : links[u]) {
+      if (a.to == skip) continue;
+      double c = cost[u] + a.cost;
+      if (c >= cost[a.to]) continue;
+      cost.set(a.to, c);
+      Q.push(a.to, c);
+    }
+  }
+}
+
+size_t Contractor::shortcuts(const size_t &v, std::vector<std::pair<std::pair<size_t, size_t>, double>> *out) {
+  const std::vector<Arc> &adj = links[v];
+  
+  // pair every neighbour with the ones after it, scanned from the back so
+  // the target set only grows
+  size_t count = 0;
+  double longest = 0;
+  targets.reset(links.size());
+  for (size_t i = adj.size(); i-- > 0; ) {
+    if (i+1 < adj.size()) {
+      targets.insert(adj[i+1].to);
+      longest = std::max(longest, adj[i+1].cost);
+    }
+    if (i+1 == adj.size()) continue;
+    witness(adj[i].to, v, adj[i].cost + longest, adj.size()-i-1, out ? settle_limit : simulate_limit);
+    for (size_t j = i+1; j < adj.size(); ++j) {
+      double via = adj[i].cost + adj[j].cost;
+      if (cost[adj[j].to] <= via) continue;
+      ++count;
+      if (out) out->push_back({{adj[i].to, adj[j].to}, via});
+    }
+  }
+  return count;
+}
+
+int Contractor::priority(const size_t &v) {
+  return 2*(int(shortcuts(v, nullptr)) - int(links[v].size())) + int(deleted[v]);
+}
+
+void Contractor::link(const size_t &u, const size_t &w, const size_t &middle, const double &c) {
+  for (Arc &a : links[u]) {
+    if (a.to != w) continue;
+    if (c < a.cost) {
+      a.cost = c;
+      a.middle = middle;
+    }
+    return;
+  }
+  links[u].push_back({uint32_t(w), uint32_t(middle), c});
+}
+
+void Contractor::unlink(const size_t &u, const size_t &v) {
+  auto it = std::find_if(links[u].begin(), links[u].end(), [&](const Arc &a) { return a.to == v; });
+  *it = links[u].back();
+  links[u].pop_back();
+}
+
+std::vector<Arc> Contractor::contract(const size_t &v) {
+  std::vector<std::pair<std::pair<size_t, size_t>, double>> added;
+  shortcuts(v, &added);
+  
+  std::vector<Arc> up;
+  up.swap(links[v]);
+  for (const Arc &a : up) {
+    unlink(a.to, v);
+    ++deleted[a.to];
+  }
+  for (const auto &sc : added) {
+    link(sc.first.first, sc.first.second, v, sc.second);
+    link(sc.first.second, sc.first.first, v, sc.second);
+  }
+  return up;
+}
+
+}
+
+const char path::Hierarchy::magic[8] = {'P', 'A', 'T', 'H', 'C', 'H', '0', '2'};
+const uint32_t path::Hierarchy::none;
+
+path::Hierarchy::Hierarchy() : n(0), m(0), sum(0), offset(1, 0) {}
+
+void path::Hierarchy::build(const Graph &graph) {
+  n = graph.size();
+  m = graph.edges();
+  sum = graph.checksum();
+  rank.assign(n, 0);
+  
+  Contractor C(graph);
+  IndexedHeap<int> order(n);
+  for (size_t v = 0; v < n; ++v) order.push(v, C.priority(v));
+  
+  std::vector<std::vector<Arc>> up(n);
+  for (uint32_t r = 0; !order.empty(); ) {
+    // lazy update, recompute the top and contract it only if it stays on top
+    size_t v = order.top();
+    int p = C.priority(v);
+    if (p > order.top_key()) {
+      order.erase(v);
+      order.push(v, p);
+      if (order.top() != v) continue;
+    }
+    order.pop();
+    rank[v] = r++;
+    up[v] = C.contract(v);
+    
+    for (const Arc &a : up[v]) {
+      order.erase(a.to);
+      order.push(a.to, C.priority(a.to));
+    }
+  }
+  
+  offset.assign(n+1, 0);
+  for (size_t v = 0; v < n; ++v) {
+    std::sort(up[v].begin(), up[v].end(), [](const Arc &a, const Arc &b) { return a.to < b.to; });
+    offset[v+1] = offset[v] + up[v].size();
+  }
+  arcs.clear();
+  arcs.reserve(offset[n]);
+  for (size_t v = 0; v < n; ++v) {
+    arcs.insert(arcs.end(), up[v].begin(), up[v].end());
+    std::vector<Arc>().swap(up[v]);
+  }
+}
+
+bool path::Hierarchy::save(const std::string &filename) const {
+  std::ofstream out(filename, std::ios::binary);
+  uint64_t header[4] = {n, m, sum, arcs.size()};
+  out.write(magic, sizeof(magic));
+  out.write(reinterpret_cast<const char *>(header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(rank.data()), rank.size() * sizeof(uint32_t));
+  out.write(reinterpret_cast<const char *>(offset.data()), offset.size() * sizeof(uint64_t));
+  out.write(reinterpret_cast<const char *>(arcs.data()), arcs.size() * sizeof(Arc));
+  return bool(out);
+}
+
+bool path::Hierarchy::load(const std::string &filename, const Graph &graph) {
+  std::ifstream in(filename, std::ios::binary);
+  char buf[sizeof(magic)];
+  uint64_t header[4];
+  if (!in.read(buf, sizeof(buf)) || std::memcmp(buf, magic, sizeof(magic)) != 0) return false;
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(header))) return false;
+  if (header[0] != graph.size() || header[1] != graph.edges()) return false;
+  // the shortcuts of another graph of the same size would unpack to arcs
+  // that are not there
+  if (header[2] != graph.checksum()) return false;
+  
+  // the arc count must match the rest of the file before it is allocated
+  const uint64_t k = header[3];
+  std::streampos start = in.tellg();
+  in.seekg(0, std::ios::end);
+  uint64_t rest = in.tellg() - start;
+  in.seekg(start);
+  if (rest < header[0] * sizeof(uint32_t) + (header[0]+1) * sizeof(uint64_t)) return false;
+  rest -= header[0] * sizeof(uint32_t) + (header[0]+1) * sizeof(uint64_t);
+  if (rest != k * sizeof(Arc)) return false;
+  
+  const size_t size = header[0];
+  std::vector<uint32_t> ranks(size);
+  std::vector<uint64_t> offsets(size+1);
+  std::vector<Arc> up(k);
+  in.read(reinterpret_cast<char *>(ranks.data()), ranks.size() * sizeof(uint32_t));
+  in.read(reinterpret_cast<char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+  in.read(reinterpret_cast<char *>(up.data()), up.size() * sizeof(Arc));
+  if (!in || offsets[0] != 0 || offsets[size] != k) return false;
+  for (size_t v = 0; v < size; ++v)
+    if (ranks[v] >= size || offsets[v] > offsets[v+1]) return false;
+  for (const Arc &a : up)
+    if (a.to >= size || (a.middle != none && a.middle >= size)) return false;
+  
+  n = size;
+  m = header[1];
+  sum = header[2];
+  rank.swap(ranks);
+  offset.swap(offsets);
+  arcs.swap(up);
+  return true;
+}
+
+const path::Hierarchy::Arc *path::Hierarchy::arc(const size_t &a, const size_t &b) const {
+  size_t lo = rank[a] < rank[b] ? a : b, hi = lo == a ? b : a;
+  Span<Arc> row = up(lo);
+  const Arc *x = std::lower_bound(row.begin(), row.end(), hi, [](const Arc &x, const size_t &v) { return x.to < v; });
+  return x != row.end() && x->to == hi ? x : nullptr;
+}
+
+bool path::Hierarchy::unpack(const size_t &a, const size_t &b, Path &path) const {
+  // explicit stack of hops, the top is the next hop in path order
+  std::vector<std::pair<size_t, size_t>> stack{{a, b}};
+  while (!stack.empty()) {
+    auto hop = stack.back();
+    stack.pop_back();
+    const Arc *x = arc(hop.first, hop.second);
+    if (!x) return false;
+    if (x->middle == none) {
+      path.push_back(hop.second);
+      continue;
+    }
+    stack.push_back({x->middle, hop.second});
+    stack.push_back({hop.first, x->middle});
+  }
+  return true;
+}
+
+path::CH::CH(const Graph &graph, const Hierarchy &hierarchy) : PathSearch(graph), H(hierarchy) {
+  Q[0] = IndexedHeap<double>(graph.size());
+  Q[1] = IndexedHeap<double>(graph.size());
+}
+
+void path::CH::find(const size_t &s, const size_t &g, Path &path) {
+  for (int d = 0; d < 2; ++d) {
+    cost[d].reset(G.size(), inf);
+    prev[d].reset(G.size(), -1);
+    Q[d].clear();
+  }
+  cost[0].set(s, 0);
+  Q[0].push(s, 0);
+  cost[1].set(g, 0);
+  Q[1].push(g, 0);
+  
+  double best = inf;
+  size_t meet = -1;
+  while (!Q[0].empty() || !Q[1].empty()) {
+    int d = Q[1].empty() || (!Q[0].empty() && Q[0].top_key() <= Q[1].top_key()) ? 0 : 1, o = 1-d;
+    
+    // nothing left in this direction can improve on best
+    if (Q[d].top_key() >= best) {
+      Q[d].clear();
+      continue;
+    }
+    
+    size_t u = Q[d].pop();
+    PATH_TRACE(tracer.expand(G, u, "Expanding: "));
+    
+    if (cost[o].contains(u) && cost[d][u] + cost[o][u] < best) {
+      best = cost[d][u] + cost[o][u];
+      meet = u;
+    }
+    
+    for (const Hierarchy::Arc &a : H.up(u)) {
+      double c = cost[d][u] + a.cost;
+      if (c >= cost[d][a.to]) continue;
+      cost[d].set(a.to, c);
+      prev[d].set(a.to, u);
+      Q[d].push(a.to, c);
+    }
+  }
+  
+  if (meet == (size_t)-1) return;
+  
+  // hops s -> meet -> g in the hierarchy, then unpack every shortcut
+  Path hops;
+  trace(prev[0], meet, hops);
+  for (size_t cur = prev[1][meet]; cur != (size_t)-1; cur = prev[1][cur])
+    hops.push_back(cur);
+  
+  path.push_back(hops[0]);
+  for (size_t i = 1; i < hops.size(); ++i) {
+    if (H.unpack(hops[i-1], hops[i], path)) continue;
+    path.clear();
+    return;
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "path.hpp"
+
+#ifndef ch_hpp
+#define ch_hpp
+
+namespace path {
+
+// contraction hierarchy over the straight-line edge costs of a graph
+//
+// vertices are contracted one by one in order of edge difference, a shortcut
+// u - w through v is added when no witness path shorter than u - v - w avoids
+// v, every arc keeps its middle vertex so shortcuts can be unpacked
+class Hierarchy {
+public:
+  struct Arc {
+    uint32_t to;
+    uint32_t middle;
+    double cost;
+  };
+  
+  static const uint32_t none = -1;
+  
+private:
+  static const char magic[8];
+  
+  // size and checksum of the graph the hierarchy was built for
+  size_t n, m;
+  uint64_t sum;
+  std::vector<uint32_t> rank;
+  // arcs from every vertex to its higher ranked neighbours, sorted by target
+  std::vector<uint64_t> offset;
+  std::vector<Arc> arcs;
+  
+public:
+  Hierarchy();
+  
+  void build(const Graph &graph);
+  
+  bool save(const std::string &filename) const;
+  
+  // returns false if the file is missing or was built for another graph
+  bool load(const std::string &filename, const Graph &graph);
+  
+  Span<Arc> up(const size_t &u) const {
+    return {arcs.data() + offset[u], arcs.data() + offset[u+1]};
+  }
+  
+  // the arc between two adjacent vertices, stored at the lower ranked one,
+  // nullptr if there is none
+  const Arc *arc(const size_t &a, const size_t &b) const;
+  
+  // replace the hop a -> b by the original vertices, appending all but a,
+  // false if a shortcut refers to an arc that does not exist
+  bool unpack(const size_t &a, const size_t &b, Path &path) const;
+};
+
+// bidirectional Dijkstra that only follows arcs upward in the hierarchy
+class CH : public PathSearch {
+private:
+  const Hierarchy &H;
+  StampedArray<double> cost[2];
+  StampedArray<size_t> prev[2];
+  IndexedHeap<double> Q[2];
+  
+public:
+  CH(const Graph &graph, const Hierarchy &hierarchy);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+}
+
+#endif /* ch_hpp */
@@ -0,0 +1,133 @@
+#include "path.hpp"
+#include "graphio.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+// writes a synthetic graph in the lab1 text format, vertices `v0`, `v1`, ...
+// with integer coordinates, then the edges
+namespace {
+
+typedef std::vector<std::pair<int, int>> Points;
+
+// spacing of neighbouring vertices, large enough that the straight-line costs
+// are not dominated by rounding
+const int unit = 100;
+
+// side x side lattice cut to n vertices, edges to the right and below
+void grid(const size_t &n, Points &points, path::Edges &edges) {
+  size_t side = std::ceil(std::sqrt(double(n)));
+  for (size_t u = 0; u < n; ++u) {
+    size_t r = u / side, c = u % side;
+    points.push_back({int(c) * unit, int(r) * unit});
+    if (c+1 < side && u+1 < n) edges.push_back({u, u+1});
+    if (u+side < n) edges.push_back({u, u+side});
+  }
+}
+
+// uniform points in a square, every pair closer than a radius is an edge, the
+// radius gives about `degree` neighbours per vertex
+void geometric(const size_t &n, const double &degree, std::mt19937_64 &rng, Points &points, path::Edges &edges) {
+  double side = std::sqrt(double(n)) * unit;
+  double radius = unit * std::sqrt(degree / M_PI);
+  std::uniform_real_distribution<double> coord(0, side);
+  for (size_t u = 0; u < n; ++u)
+    points.push_back({int(coord(rng)), int(coord(rng))});
+  
+  // bucket the points into cells of the radius so only adjacent cells are compared
+  size_t cells = std::max<size_t>(1, size_t(side / radius));
+  std::vector<std::vector<size_t>> bucket(cells * cells);
+  auto cell = [&](const int &x) { return std::min(cells-1, size_t(x / radius)); };
+  for (size_t u = 0; u < n; ++u)
+    bucket[cell(points[u].second) * cells + cell(points[u].first)].push_back(u);
+  
+  for (size_t u = 0; u < n; ++u) {
+    size_t cx = cell(points[u].first), cy = cell(points[u].second);
+    for (size_t y = cy ? cy-1 : 0; y <= std::min(cells-1, cy+1); ++y) {
+      for (size_t x = cx ? cx-1 : 0; x <= std::min(cells-1, cx+1); ++x) {
+        for (const size_t &v : bucket[y * cells + x]) {
+          if (v <= u) continue;
+          double dx = points[u].first - points[v].first, dy = points[u].second - points[v].second;
+          if (dx*dx + dy*dy <= radius*radius) edges.push_back({u, v});
+        }
+      }
+    }
+  }
+}
+
+// Barabasi-Albert preferential attachment, every new vertex links to `degree`
+// earlier vertices picked in proportion to their degree
+void scalefree(const size_t &n, const size_t &degree, std::mt19937_64 &rng, Points &points, path::Edges &edges) {
+  double side = std::sqrt(double(n)) * unit;
+  std::uniform_real_distribution<double> coord(0, side);
+  for (size_t u = 0; u < n; ++u)
+    points.push_back({int(coord(rng)), int(coord(rng))});
+  
+  // every edge puts both ends here, so a uniform pick is degree-proportional
+  std::vector<size_t> ends;
+  size_t seed = std::min(n, degree + 1);
+  for (size_t u = 0; u < seed; ++u) {
+    for (size_t v = u+1; v < seed; ++v) {
+      edges.push_back({u, v});
+      ends.push_back(u);
+      ends.push_back(v);
+    }
+  }
+  std::vector<size_t> picked;
+  for (size_t u = seed; u < n; ++u) {
+    picked.clear();
+    while (picked.size() < degree) {
+      size_t v = ends[std::uniform_int_distribution<size_t>(0, ends.size()-1)(rng)];
+      if (std::find(picked.begin(), picked.end(), v) == picked.end()) picked.push_back(v);
+    }
+    for (const size_t &v : picked) {
+      edges.push_back({v, u});
+      ends.push_back(v);
+      ends.push_back(u);
+    }
+  }
+}
+
+}
+
+int main(int argc, char * argv[]) {
+  if (argc < 3 || argc > 4) {
+    std::cerr << (argc < 3 ? "Too few" : "Too many") << " arguments. Usage: graphgen <grid|geometric|scalefree> <vertices> [seed]\n";
+    return 1;
+  }
+  
+  std::string kind = argv[1];
+  if (kind != "grid" && kind != "geometric" && kind != "scalefree") {
+    std::cerr << "Unknown graph kind `" << kind << "`, expect grid, geometric or scalefree\n";
+    return 1;
+  }
+  if (!path::isint(argv[2]) || std::atoll(argv[2]) <= 0) {
+    std::cerr << "Invalid argument. The number of vertices should be a positive integer\n";
+    return 1;
+  }
+  if (argc == 4 && !path::isint(argv[3])) {
+    std::cerr << "Invalid argument. The seed should be an integer\n";
+    return 1;
+  }
+  size_t n = std::atoll(argv[2]);
+  std::mt19937_64 rng(argc == 4 ? std::atoll(argv[3]) : 1);
+  
+  Points points;
+  path::Edges edges;
+  if (kind == "grid")           grid(n, points, edges);
+  else if (kind == "geometric") geometric(n, 6, rng, points, edges);
+  else                          scalefree(n, 3, rng, points, edges);
+  
+  std::ios::sync_with_stdio(false);
+  std::cout << "# " << kind << ", " << n << " vertices, " << edges.size() << " edges\n";
+  for (size_t u = 0; u < n; ++u)
+    std::cout << "v" << u << " " << points[u].first << " " << points[u].second << "\n";
+  std::cout << "\n";
+  for (const auto &e : edges)
+    std::cout << "v" << e.first << " v" << e.second << "\n";
+  return 0;
+}
@@ -0,0 +1,249 @@
+#include "graphio.hpp"
+#include "stats.hpp"
+#include "perfect.hpp"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+namespace {
+
+// a 3-token line is a vertex when both coordinates are integers, otherwise it
+// is an edge with a weight
+bool vertex_line(const std::vector<std::string> &tokens) {
+  return tokens.size() == 3 && path::isint(tokens[1]) && path::isint(tokens[2]);
+}
+
+// same formula as Graph::dist so mixed inputs cost the same as unweighted ones
+double euclid(const path::Node &a, const path::Node &b) {
+  return std::sqrt(std::pow(a.x-b.x, 2) + std::pow(a.y-b.y, 2));
+}
+
+bool isweight(const std::string &s, double &w) {
+  char *end = nullptr;
+  w = std::strtod(s.c_str(), &end);
+  return !s.empty() && *end == '\0' && std::isfinite(w) && w >= 0;
+}
+
+// the labels of the sorted vertex list, resolved through a perfect hash
+class Labels {
+private:
+  const path::Nodes &nodes;
+  const std::string &arena;
+  path::PerfectHash hash;
+  
+public:
+  Labels(const path::Nodes &nodes, const std::string &arena) : nodes(nodes), arena(arena) {
+    hash.build(nodes.size(), [&](const size_t &i) {
+      return std::make_pair(arena.data() + nodes[i].label, size_t(nodes[i].length));
+    });
+  }
+  
+  size_t find(const std::string &label) const {
+    size_t i = hash.find(label.data(), label.size());
+    if (i == path::PerfectHash::npos || nodes[i].length != label.size()) return path::Graph::npos;
+    return std::memcmp(arena.data() + nodes[i].label, label.data(), label.size()) == 0 ? i : path::Graph::npos;
+  }
+};
+
+int compare(const std::string &arena, const path::Node &a, const path::Node &b) {
+  int c = std::memcmp(arena.data() + a.label, arena.data() + b.label, std::min(a.length, b.length));
+  return c != 0 ? c : int(a.length > b.length) - int(a.length < b.length);
+}
+
+// labels are appended to one arena, a vertex only keeps its slice
+bool load_vertices(const std::string &filename, path::Nodes &nodes, std::string &arena) {
+  std::ifstream in(filename);
+  
+  std::string line;
+  size_t linenum = 0;
+  while (std::getline(in, line)) {
+    ++linenum;
+    if (line.empty() || line[0] == '#') continue;
+    
+    std::istringstream ss(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (ss >> token)
+      tokens.push_back(token);
+    
+    if (tokens.size() == 2 || (tokens.size() == 3 && !vertex_line(tokens))) continue;
+    else if (vertex_line(tokens)) {
+      nodes.push_back({arena.size(), uint32_t(tokens[0].size()), stoi(tokens[1]), stoi(tokens[2])});
+      arena += tokens[0];
+    }
+    else {
+      std::cerr << "Invalid input file format. line " << linenum << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+// an edge without a weight costs the straight-line distance, `weights` stays
+// empty unless some edge has one
+bool load_edges(const std::string &filename, const path::Nodes &nodes, const Labels &labels, path::Edges &edges, path::Weights &weights) {
+  std::ifstream in(filename);
+  
+  std::string line;
+  size_t linenum = 0;
+  bool weighted = false;
+  while (std::getline(in, line)) {
+    ++linenum;
+    if (line.empty() || line[0] == '#') continue;
+    
+    std::istringstream ss(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (ss >> token)
+      tokens.push_back(token);
+    
+    if (vertex_line(tokens)) continue;
+    
+    size_t u = labels.find(tokens[0]), v = labels.find(tokens[1]);
+    if (u == path::Graph::npos || v == path::Graph::npos) {
+      std::cerr << "Reference to vertex not in the file. line " << linenum << "\n";
+      return false;
+    }
+    
+    double w = 0;
+    if (tokens.size() == 3 && !isweight(tokens[2], w)) {
+      std::cerr << "Invalid edge weight, expect a non-negative number. line " << linenum << "\n";
+      return false;
+    }
+    if (tokens.size() == 2) w = euclid(nodes[u], nodes[v]);
+    else weighted = true;
+    
+    edges.push_back({u, v});
+    weights.push_back(w);
+  }
+  if (!weighted) path::Weights().swap(weights);
+  return true;
+}
+
+}
+
+bool path::load_text(const std::string &filename, Graph &graph, double *build) {
+  path::Nodes nodes;
+  std::string arena;
+  if (!load_vertices(filename, nodes, arena)) return false;
+  std::sort(nodes.begin(), nodes.end(), [&](const path::Node &a, const path::Node &b) {
+    return compare(arena, a, b) < 0;
+  });
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    if (compare(arena, nodes[i-1], nodes[i]) == 0) {
+      std::cerr << "Redefinition of vertex `" << arena.substr(nodes[i].label, nodes[i].length) << "`\n";
+      return false;
+    }
+  }
+  
+  path::Edges edges;
+  path::Weights weights;
+  {
+    Labels labels(nodes, arena);
+    if (!load_edges(filename, nodes, labels, edges, weights)) return false;
+  }
+  
+  // freeze into CSR form
+  Stopwatch watch;
+  graph.build(nodes, arena, edges, weights);
+  if (build) *build = watch.lap();
+  return true;
+}
+
+bool path::load(const std::string &filename, Graph &graph, double *build) {
+  if (!Graph::packed(filename)) return load_text(filename, graph, build);
+  if (build) *build = 0;
+  if (!graph.open(filename)) {
+    std::cerr << "Corrupted or outdated packed graph file `" << filename << "`, rebuild it with graphpack\n";
+    return false;
+  }
+  return true;
+}
+
+bool path::load_queries(const std::string &filename, const Graph &graph, Queries &queries) {
+  std::ifstream in(filename);
+  if (!in) {
+    std::cerr << "Failed to open query file `" << filename << "`\n";
+    return false;
+  }
+  
+  std::string line;
+  size_t linenum = 0;
+  while (std::getline(in, line)) {
+    ++linenum;
+    if (line.empty() || line[0] == '#') continue;
+    
+    std::istringstream ss(line);
+    std::string start, goal, extra;
+    if (!(ss >> start)) continue;
+    if (!(ss >> goal) || (ss >> extra)) {
+      std::cerr << "Invalid query file format. line " << linenum << "\n";
+      return false;
+    }
+    
+    size_t s = graph.find(start), g = graph.find(goal);
+    if (s == Graph::npos || g == Graph::npos) {
+      std::cerr << "Reference to vertex not in the graph. line " << linenum << "\n";
+      return false;
+    }
+    queries.push_back({s, g});
+  }
+  return true;
+}
+
+bool path::load_labels(const std::string &filename, const Graph &graph, std::vector<size_t> &vertices) {
+  std::ifstream in(filename);
+  if (!in) {
+    std::cerr << "Failed to open vertex file `" << filename << "`\n";
+    return false;
+  }
+  
+  std::string line;
+  size_t linenum = 0;
+  while (std::getline(in, line)) {
+    ++linenum;
+    if (line.empty() || line[0] == '#') continue;
+    
+    std::istringstream ss(line);
+    std::string label, extra;
+    if (!(ss >> label)) continue;
+    if (ss >> extra) {
+      std::cerr << "Invalid vertex file format, expect one label per line. line " << linenum << "\n";
+      return false;
+    }
+    
+    size_t u = graph.find(label);
+    if (u == Graph::npos) {
+      std::cerr << "Reference to vertex not in the graph. line " << linenum << "\n";
+      return false;
+    }
+    vertices.push_back(u);
+  }
+  return true;
+}
+
+bool path::parse_update(const std::string &line, const size_t &linenum, const Graph &graph, Update &update) {
+  std::istringstream ss(line);
+  std::string op, u, v, extra;
+  ss >> op;
+  if (op == "plan" && !(ss >> extra)) {
+    update.op = Update::plan;
+    return true;
+  }
+  if ((op != "add" && op != "del") || !(ss >> u >> v) || (ss >> extra)) {
+    std::cerr << "Invalid update, expect `add <u> <v>`, `del <u> <v>` or `plan`. line " << linenum << "\n";
+    return false;
+  }
+  update.op = op == "add" ? Update::add : Update::del;
+  update.u = graph.find(u);
+  update.v = graph.find(v);
+  if (update.u == Graph::npos || update.v == Graph::npos) {
+    std::cerr << "Reference to vertex not in the graph. line " << linenum << "\n";
+    return false;
+  }
+  return true;
+}
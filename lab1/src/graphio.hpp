@@ -0,0 +1,42 @@
+#pragma once
+#include "path.hpp"
+#include <string>
+#include <cctype>
+
+#ifndef graphio_hpp
+#define graphio_hpp
+
+namespace path {
+
+bool inline isint(const std::string& s) {
+  if (s.empty()) return false;
+  size_t x = s.find_first_not_of("0123456789", 1);
+  return (x == std::string::npos) && (isdigit(s[0]) || ((s[0] == '+' || s[0] == '-') && s.size() > 1));
+}
+
+// parse the text format: `<label> <x> <y>` vertex lines and `<u> <v>` edge lines,
+// `build` receives the seconds spent freezing the parsed lists into the graph
+bool load_text(const std::string &filename, Graph &graph, double *build = nullptr);
+
+// parse a query file with one `<start> <goal>` pair per line
+bool load_queries(const std::string &filename, const Graph &graph, Queries &queries);
+
+// parse a file with one vertex label per line, as used by the distance matrix
+bool load_labels(const std::string &filename, const Graph &graph, std::vector<size_t> &vertices);
+
+// one command of an edge update stream, `add <u> <v>`, `del <u> <v>` or `plan`
+struct Update {
+  enum Op { add, del, plan };
+  Op op;
+  size_t u, v;
+};
+
+// parse one non-empty, non-comment line of an update stream
+bool parse_update(const std::string &line, const size_t &linenum, const Graph &graph, Update &update);
+
+// load either a packed graph (mapped) or the text format, decided by the file magic
+bool load(const std::string &filename, Graph &graph, double *build = nullptr);
+
+}
+
+#endif /* graphio_hpp */
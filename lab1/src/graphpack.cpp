@@ -0,0 +1,21 @@
+#include "path.hpp"
+#include "graphio.hpp"
+#include <iostream>
+#include <string>
+
+// compiles the lab1 text format into a packed graph that `lab1` maps directly
+int main(int argc, char * argv[]) {
+  if (argc != 3) {
+    std::cerr << (argc < 3 ? "Too few" : "Too many") << " arguments. Usage: graphpack <input_file> <output_file>\n";
+    return 1;
+  }
+  
+  path::Graph graph;
+  if (!path::load_text(argv[1], graph)) return 1;
+  if (!graph.save(argv[2])) {
+    std::cerr << "Failed to write `" << argv[2] << "`\n";
+    return 1;
+  }
+  std::cout << graph.size() << " vertices, " << graph.edges() << " arcs\n";
+  return 0;
+}
@@ -0,0 +1,177 @@
+#include "hda.hpp"
+#include "stats.hpp"
+#include <atomic>
+#include <thread>
+#include <queue>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+const std::memory_order relaxed = std::memory_order_relaxed;
+
+// a generated vertex on its way to its owner
+struct Message {
+  uint32_t v, parent;
+  double g;
+};
+
+struct Batch {
+  std::vector<Message> items;
+  Batch *next;
+};
+
+// multi-producer inbox, senders push whole batches with a CAS on the head and
+// the owner takes everything at once by swapping the head out
+struct alignas(64) Inbox {
+  std::atomic<Batch *> head;
+  
+  Inbox() : head(nullptr) {}
+  
+  void push(Batch *batch) {
+    batch->next = head.load(relaxed);
+    while (!head.compare_exchange_weak(batch->next, batch, std::memory_order_release, relaxed));
+  }
+  
+  Batch *take() {
+    if (!head.load(relaxed)) return nullptr;
+    return head.exchange(nullptr, std::memory_order_acquire);
+  }
+  
+  bool empty() const { return !head.load(relaxed); }
+};
+
+// open list entry, stale once the owner has seen a smaller g for v
+struct Entry {
+  double f, g;
+  uint32_t v;
+  bool operator<(const Entry &e) const { return f > e.f; }
+};
+
+}
+
+path::HDASTAR::HDASTAR(const Graph &graph, const unsigned &threads) : PathSearch(graph), threads(std::max(1u, threads)) {}
+
+void path::HDASTAR::find(const size_t &s, const size_t &g, Path &path) {
+  static const double inf = std::numeric_limits<double>::infinity();
+  // messages are sent once this many are buffered for one owner, or sooner
+  // when the sender runs out of work
+  static const size_t batch_size = 64, flush_every = 32;
+  
+  gval.reset(G.size(), inf);
+  prev.reset(G.size(), -1);
+  
+  const unsigned T = threads;
+  auto owner = [&](const size_t &v) -> unsigned {
+    return ((v * 0x9E3779B97F4A7C15ull) >> 32) % T;
+  };
+  
+  std::vector<Inbox> inbox(T);
+  std::vector<Stats> counted(T);
+  
+  // cost of the best path to g found so far, only lowered by the owner of g
+  std::atomic<double> best(inf);
+  
+  // busy threads plus messages in flight, a message is counted before it is
+  // sent and a thread before it consumes one, so this only reaches zero when
+  // every thread is idle and nothing is on its way
+  std::atomic<int64_t> work(T);
+  
+  auto worker = [&](const unsigned &t) {
+    std::priority_queue<Entry> open;
+    std::vector<std::vector<Message>> outbox(T);
+    Stats &mine = counted[t];
+    size_t since_flush = 0;
+    
+    auto send = [&](const unsigned &to) {
+      if (outbox[to].empty()) return;
+      Batch *batch = new Batch;
+      batch->items.swap(outbox[to]);
+      work.fetch_add(batch->items.size(), relaxed);
+      inbox[to].push(batch);
+    };
+    
+    auto flush = [&]() {
+      for (unsigned to = 0; to < T; ++to) send(to);
+      since_flush = 0;
+    };
+    
+    // owner side of a relaxation
+    auto receive = [&](const Message &m) {
+      if (m.g >= gval[m.v]) return;
+      gval.set(m.v, m.g);
+      if (m.parent != uint32_t(-1)) prev.set(m.v, m.parent);
+      if (m.v == g) {
+        double b = best.load(relaxed);
+        while (m.g < b && !best.compare_exchange_weak(b, m.g, relaxed));
+        return;
+      }
+      open.push({m.g + dist(m.v, g), m.g, m.v});
+      mine.open(open.size());
+    };
+    
+    auto drain = [&]() {
+      Batch *batch = inbox[t].take();
+      while (batch) {
+        for (const Message &m : batch->items) receive(m);
+        work.fetch_sub(batch->items.size(), relaxed);
+        Batch *next = batch->next;
+        delete batch;
+        batch = next;
+      }
+    };
+    
+    if (owner(s) == t) receive({uint32_t(s), uint32_t(-1), 0});
+    
+    while (true) {
+      drain();
+      
+      // drop entries that are stale or cannot beat the best goal cost
+      while (!open.empty() && (open.top().g > gval[open.top().v] || open.top().f >= best.load(relaxed)))
+        open.pop();
+      
+      if (!open.empty()) {
+        Entry e = open.top();
+        open.pop();
+        ++mine.expanded;
+        for (const size_t v : G.adj(e.v)) {
+          ++mine.relaxed;
+          double gv = e.g + dist(e.v, v);
+          if (gv + dist(v, g) >= best.load(relaxed)) continue;
+          unsigned to = owner(v);
+          if (to == t) receive({uint32_t(v), e.v, gv});
+          else {
+            outbox[to].push_back({uint32_t(v), e.v, gv});
+            if (outbox[to].size() >= batch_size) send(to);
+          }
+        }
+        if (++since_flush >= flush_every) flush();
+        continue;
+      }
+      
+      // out of work, hand over what is buffered and wait for messages
+      flush();
+      if (!inbox[t].empty()) continue;
+      work.fetch_sub(1, relaxed);
+      while (inbox[t].empty() && work.load(relaxed) != 0)
+        std::this_thread::yield();
+      if (work.load(std::memory_order_acquire) == 0 && inbox[t].empty()) break;
+      work.fetch_add(1, relaxed);
+    }
+  };
+  
+  std::vector<std::thread> team;
+  for (unsigned t = 1; t < T; ++t)
+    team.emplace_back(worker, t);
+  worker(0);
+  for (auto &th : team) th.join();
+  
+  for (const Stats &c : counted) {
+    stats.expanded += c.expanded;
+    stats.relaxed += c.relaxed;
+    stats.open(c.peak_open);
+  }
+  
+  if (best.load() == inf) return;
+  trace(prev, g, path);
+}
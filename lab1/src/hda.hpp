@@ -0,0 +1,31 @@
+#pragma once
+#include "path.hpp"
+
+#ifndef hda_hpp
+#define hda_hpp
+
+namespace path {
+
+// hash-distributed A* (Kishimoto et al.), every vertex is owned by the thread
+// its index hashes to and only that thread keeps its g-value, parent and open
+// list entry. Generated vertices are sent to their owner through lock-free
+// inboxes, a vertex is reopened whenever a cheaper path to it arrives
+//
+// the search ends when no thread has an open vertex with f below the best
+// goal cost found and no message is in flight, the cost then equals the one
+// of the sequential ASTAR
+class HDASTAR : public PathSearch {
+private:
+  unsigned threads;
+  StampedArray<double> gval;
+  StampedArray<size_t> prev;
+  
+public:
+  HDASTAR(const Graph &graph, const unsigned &threads);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+}
+
+#endif /* hda_hpp */
@@ -0,0 +1,207 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#ifndef heap_hpp
+#define heap_hpp
+
+namespace path {
+
+// d-ary min-heap over vertex indices [0, n) with decrease-key
+template <typename Key, unsigned D = 4, typename Compare = std::less<Key>>
+class IndexedHeap {
+private:
+  static const size_t npos = -1;
+  
+  std::vector<size_t> heap;
+  std::vector<size_t> pos;
+  std::vector<Key> key;
+  Compare less;
+  
+  void sift_up(size_t i);
+  
+  void sift_down(size_t i);
+  
+  void place(const size_t &i, const size_t &u);
+  
+public:
+  IndexedHeap(const size_t &n = 0);
+  
+  bool empty() const { return heap.empty(); }
+  
+  size_t size() const { return heap.size(); }
+  
+  bool contains(const size_t &u) const { return pos[u] != npos; }
+  
+  size_t top() const { return heap.front(); }
+  
+  const Key &top_key() const { return key[heap.front()]; }
+  
+  const Key &priority(const size_t &u) const { return key[u]; }
+  
+  // insert u, or lower its key if it is already queued with a larger one
+  bool push(const size_t &u, const Key &k);
+  
+  size_t pop();
+  
+  void erase(const size_t &u);
+  
+  void clear();
+};
+
+// monotone radix heap over integer keys, keys pushed must not be smaller than
+// the last key popped, which holds for Dijkstra with non-negative integer
+// costs. There is no decrease-key, push again and skip stale entries on pop
+template <typename T>
+class RadixHeap {
+private:
+  std::vector<std::pair<uint64_t, T>> buckets[65];
+  uint64_t last;
+  size_t count;
+  
+  // bucket i holds keys whose highest bit differing from `last` is bit i-1
+  static size_t bucket(const uint64_t &key, const uint64_t &last) {
+    return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+  }
+  
+  void pull();
+  
+public:
+  RadixHeap() : last(0), count(0) {}
+  
+  bool empty() const { return count == 0; }
+  
+  size_t size() const { return count; }
+  
+  void push(const T &item, const uint64_t &key);
+  
+  T pop();
+  
+  void clear();
+};
+
+}
+
+template <typename Key, unsigned D, typename Compare>
+const size_t path::IndexedHeap<Key, D, Compare>::npos;
+
+template <typename Key, unsigned D, typename Compare>
+path::IndexedHeap<Key, D, Compare>::IndexedHeap(const size_t &n) : pos(n, npos), key(n) {}
+
+template <typename Key, unsigned D, typename Compare>
+void path::IndexedHeap<Key, D, Compare>::place(const size_t &i, const size_t &u) {
+  heap[i] = u;
+  pos[u] = i;
+}
+
+template <typename Key, unsigned D, typename Compare>
+void path::IndexedHeap<Key, D, Compare>::sift_up(size_t i) {
+  size_t u = heap[i];
+  while (i > 0) {
+    size_t p = (i-1) / D;
+    if (!less(key[u], key[heap[p]])) break;
+    place(i, heap[p]);
+    i = p;
+  }
+  place(i, u);
+}
+
+template <typename Key, unsigned D, typename Compare>
+void path::IndexedHeap<Key, D, Compare>::sift_down(size_t i) {
+  size_t u = heap[i];
+  while (true) {
+    size_t c = i*D + 1, best = c;
+    if (c >= heap.size()) break;
+    for (size_t j = c+1; j < c+D && j < heap.size(); ++j) {
+      if (less(key[heap[j]], key[heap[best]])) best = j;
+    }
+    if (!less(key[heap[best]], key[u])) break;
+    place(i, heap[best]);
+    i = best;
+  }
+  place(i, u);
+}
+
+template <typename Key, unsigned D, typename Compare>
+bool path::IndexedHeap<Key, D, Compare>::push(const size_t &u, const Key &k) {
+  if (pos[u] == npos) {
+    key[u] = k;
+    heap.push_back(u);
+    pos[u] = heap.size()-1;
+    sift_up(heap.size()-1);
+    return true;
+  }
+  if (!less(k, key[u])) return false;
+  key[u] = k;
+  sift_up(pos[u]);
+  return true;
+}
+
+template <typename Key, unsigned D, typename Compare>
+size_t path::IndexedHeap<Key, D, Compare>::pop() {
+  size_t u = heap.front();
+  erase(u);
+  return u;
+}
+
+template <typename Key, unsigned D, typename Compare>
+void path::IndexedHeap<Key, D, Compare>::erase(const size_t &u) {
+  size_t i = pos[u];
+  size_t last = heap.back();
+  heap.pop_back();
+  pos[u] = npos;
+  if (last == u) return;
+  place(i, last);
+  sift_up(i);
+  sift_down(pos[last]);
+}
+
+template <typename Key, unsigned D, typename Compare>
+void path::IndexedHeap<Key, D, Compare>::clear() {
+  for (const size_t &u : heap) pos[u] = npos;
+  heap.clear();
+}
+
+template <typename T>
+void path::RadixHeap<T>::pull() {
+  if (!buckets[0].empty()) return;
+  
+  size_t i = 1;
+  while (buckets[i].empty()) ++i;
+  
+  // the smallest key of the first non-empty bucket becomes the new base, every
+  // entry of that bucket then lands in a strictly lower one
+  uint64_t least = buckets[i][0].first;
+  for (const auto &e : buckets[i]) least = std::min(least, e.first);
+  last = least;
+  for (const auto &e : buckets[i]) buckets[bucket(e.first, last)].push_back(e);
+  buckets[i].clear();
+}
+
+template <typename T>
+void path::RadixHeap<T>::push(const T &item, const uint64_t &key) {
+  buckets[bucket(key, last)].emplace_back(key, item);
+  ++count;
+}
+
+template <typename T>
+T path::RadixHeap<T>::pop() {
+  pull();
+  T item = buckets[0].back().second;
+  buckets[0].pop_back();
+  --count;
+  return item;
+}
+
+template <typename T>
+void path::RadixHeap<T>::clear() {
+  for (auto &b : buckets) b.clear();
+  last = 0;
+  count = 0;
+}
+
+#endif /* heap_hpp */
@@ -0,0 +1,153 @@
+#include "lpa.hpp"
+#include "tracing.hpp"
+#include "stats.hpp"
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+const double inf = std::numeric_limits<double>::infinity();
+
+}
+
+path::LPASTAR::LPASTAR(const Graph &graph) : PathSearch(graph), start(-1), goal(-1), U(graph.size()) {}
+
+uint64_t path::LPASTAR::edge(const size_t &u, const size_t &v) {
+  return (uint64_t(std::min(u, v)) << 32) | std::max(u, v);
+}
+
+path::LPASTAR::Key path::LPASTAR::key(const size_t &u) const {
+  double m = std::min(gval[u], rhs[u]);
+  return Key(m + h(u), m);
+}
+
+template <typename F>
+void path::LPASTAR::neighbours(const size_t &u, const F &f) const {
+  for (const size_t v : G.adj(u)) {
+    if (!removed.empty() && removed.count(edge(u, v))) continue;
+    f(v);
+  }
+  auto it = added.find(u);
+  if (it == added.end()) return;
+  for (const size_t v : it->second) f(v);
+}
+
+bool path::LPASTAR::connected(const size_t &u, const size_t &v) const {
+  if (removed.count(edge(u, v))) return false;
+  Span<uint32_t> row = G.adj(u);
+  if (std::binary_search(row.begin(), row.end(), v)) return true;
+  auto it = added.find(u);
+  return it != added.end() && std::find(it->second.begin(), it->second.end(), v) != it->second.end();
+}
+
+bool path::LPASTAR::add(const size_t &u, const size_t &v) {
+  if (connected(u, v)) return false;
+  // a removed edge of the graph comes back, anything else goes to the overlay
+  if (!removed.erase(edge(u, v))) {
+    added[u].push_back(v);
+    if (u != v) added[v].push_back(u);
+  }
+  if (start != (size_t)-1) {
+    update(u);
+    update(v);
+  }
+  return true;
+}
+
+bool path::LPASTAR::erase(const size_t &u, const size_t &v) {
+  if (!connected(u, v)) return false;
+  Span<uint32_t> row = G.adj(u);
+  if (std::binary_search(row.begin(), row.end(), v)) {
+    removed.insert(edge(u, v));
+  }
+  else {
+    auto unlink = [&](const size_t &a, const size_t &b) {
+      std::vector<uint32_t> &list = added[a];
+      list.erase(std::find(list.begin(), list.end(), b));
+      if (list.empty()) added.erase(a);
+    };
+    unlink(u, v);
+    if (u != v) unlink(v, u);
+  }
+  if (start != (size_t)-1) {
+    update(u);
+    update(v);
+  }
+  return true;
+}
+
+// rhs is the best one-step lookahead through the neighbours, u goes on the
+// queue exactly when it is inconsistent
+void path::LPASTAR::update(const size_t &u) {
+  if (u != start) {
+    double best = inf;
+    neighbours(u, [&](const size_t &v) {
+      ++stats.relaxed;
+      best = std::min(best, gval[v] + dist(v, u));
+    });
+    rhs.set(u, best);
+  }
+  if (U.contains(u)) U.erase(u);
+  if (gval[u] != rhs[u]) U.push(u, key(u));
+}
+
+void path::LPASTAR::compute() {
+  auto relax = [&](const size_t &v) { update(v); };
+  while (!U.empty() && (U.top_key() < key(goal) || rhs[goal] != gval[goal])) {
+    size_t u = U.pop();
+    PATH_TRACE(tracer.expand(G, u, "Expand: "));
+    ++stats.expanded;
+    
+    if (gval[u] > rhs[u]) {
+      gval.set(u, rhs[u]);
+      neighbours(u, relax);
+    }
+    else {
+      // underconsistent, the cost went up, u and everything it fed are redone
+      gval.set(u, inf);
+      update(u);
+      neighbours(u, relax);
+    }
+    stats.open(U.size());
+  }
+}
+
+void path::LPASTAR::find(const size_t &s, const size_t &g, Path &path) {
+  // the g and rhs values are only valid for the start and goal they were
+  // computed for, another pair starts over
+  if (s != start || g != goal) {
+    start = s;
+    goal = g;
+    gval.reset(G.size(), inf);
+    rhs.reset(G.size(), inf);
+    U.clear();
+    rhs.set(s, 0);
+    U.push(s, key(s));
+  }
+  compute();
+  
+  if (gval[goal] == inf) return;
+  
+  // walk back over neighbours v with g(v) + d(v, u) = g(u), the smallest g(v)
+  // first. Zero-length edges between co-located vertices tie, so a vertex is
+  // entered once and a dead end backs up; if the start is never reached no
+  // path is returned rather than one that does not begin at the start
+  std::vector<size_t> walk(1, goal);
+  std::unordered_set<size_t> visited{goal};
+  while (!walk.empty() && walk.back() != start) {
+    size_t u = walk.back(), best = -1;
+    double slack = 1e-9 * std::max(1.0, gval[u]), low = inf;
+    neighbours(u, [&](const size_t &v) {
+      if (gval[v] + dist(v, u) > gval[u] + slack || gval[v] >= low || visited.count(v)) return;
+      low = gval[v];
+      best = v;
+    });
+    if (best == (size_t)-1) {
+      walk.pop_back();
+      continue;
+    }
+    visited.insert(best);
+    walk.push_back(best);
+  }
+  path.insert(path.end(), walk.rbegin(), walk.rend());
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "path.hpp"
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#ifndef lpa_hpp
+#define lpa_hpp
+
+namespace path {
+
+// Lifelong Planning A* (Koenig, Likhachev and Furcy), keeps its g and rhs
+// values between calls to find, so after a few edge changes a replan for the
+// same start and goal only revisits the vertices whose cost changed
+//
+// edge changes live in an overlay on top of the frozen graph, added edges
+// cost the straight-line distance like every other edge, and the heuristic is
+// the one of ASTAR
+class LPASTAR : public PathSearch {
+private:
+  typedef std::pair<double, double> Key;
+  
+  size_t start, goal;
+  StampedArray<double> gval, rhs;
+  IndexedHeap<Key> U;
+  
+  std::unordered_map<uint32_t, std::vector<uint32_t>> added;
+  std::unordered_set<uint64_t> removed;
+  
+  static uint64_t edge(const size_t &u, const size_t &v);
+  
+  double h(const size_t &u) const { return dist(u, goal); }
+  
+  Key key(const size_t &u) const;
+  
+  // calls f(v) for every neighbour of u in the current graph
+  template <typename F>
+  void neighbours(const size_t &u, const F &f) const;
+  
+  void update(const size_t &u);
+  
+  void compute();
+  
+public:
+  LPASTAR(const Graph &graph);
+  
+  bool connected(const size_t &u, const size_t &v) const;
+  
+  // add or remove the undirected edge u-v, returns false if nothing changed
+  bool add(const size_t &u, const size_t &v);
+  
+  bool erase(const size_t &u, const size_t &v);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+}
+
+#endif /* lpa_hpp */
@@ -1,21 +1,31 @@
 #include "path.hpp"
+#include "pbfs.hpp"
+#include "graphio.hpp"
+#include "batch.hpp"
+#include "alt.hpp"
+#include "ch.hpp"
+#include "tracing.hpp"
+#include "stats.hpp"
+#include "sssp.hpp"
+#include "hda.hpp"
+#include "lpa.hpp"
+#include "cache.hpp"
 #include <iostream>
-#include <iomanip>
-#include <fstream>
-#include <sstream>
 #include <string>
-#include <unordered_map>
+#include <fstream>
+#include <iomanip>
 #include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include <cmath>
 #include <getopt.h>
 
-std::string start, goal, alg, input;
+std::string start, goal, alg, input, queries, landmarks, hierarchy, updates, sources, targets;
 int depth = 0;
-
-bool inline isint(const std::string& s) {
-  if (s.empty()) return false;
-  size_t x = s.find_first_not_of("0123456789", 1);
-  return (x == std::string::npos) && (isdigit(s[0]) || ((s[0] == '+' || s[0] == '-') && s.size() > 1));
-}
+unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+size_t count = 0, cached = 0;
+double delta = 0;
+bool report = false, binary = false;
 
 bool arguments(int argc, char * argv[]) {
   const option options[] = {
@@ -24,16 +34,53 @@ bool arguments(int argc, char * argv[]) {
     {"goal",    required_argument, nullptr, 'g'},
     {"alg",     required_argument, nullptr, 'a'},
     {"depth",   required_argument, nullptr, 'd'},
+    {"threads", required_argument, nullptr, 't'},
+    {"queries", required_argument, nullptr, 'q'},
+    {"landmarks", required_argument, nullptr, 'l'},
+    {"count",   required_argument, nullptr, 'k'},
+    {"hierarchy", required_argument, nullptr, 'c'},
+    {"trace",   required_argument, nullptr, 'T'},
+    {"stats",   no_argument,       nullptr, 'S'},
+    {"delta",   required_argument, nullptr, 'D'},
+    {"updates", required_argument, nullptr, 'u'},
+    {"matrix",  required_argument, nullptr, 'M'},
+    {"binary",  no_argument,       nullptr, 'B'},
+    {"cache",   required_argument, nullptr, 'C'},
     {nullptr,   no_argument,       nullptr,  0}
   };
   
   int c = 0, idx = 0;
-  while ((c = getopt_long(argc, argv, "vs:g:a:d:", options, &idx)) != -1) {
+  while ((c = getopt_long(argc, argv, "vs:g:a:d:t:q:l:k:c:T:u:", options, &idx)) != -1) {
     switch (c) {
       case 'v':
-        path::verbose.rdbuf(std::cout.rdbuf());
-        path::verbose << std::fixed << std::setprecision(2);
+        if (path::tracer.enabled()) {
+          std::cerr << "Invalid arguments. `-v` and `--trace` cannot be used together\n";
+          return false;
+        }
+        path::tracer.open(path::Tracer::text);
+        break;
+      case 'T':
+        if (path::tracer.enabled()) {
+          std::cerr << "Invalid arguments. `-v` and `--trace` cannot be used together\n";
+          return false;
+        }
+        if (!path::tracer.open(path::Tracer::json, optarg)) {
+          std::cerr << "Failed to open trace file `" << optarg << "`\n";
+          return false;
+        }
+        break;
+      case 'S':
+        report = true;
+        break;
+      case 'D': {
+        char *end = nullptr;
+        delta = std::strtod(optarg, &end);
+        if (*end != '\0' || !std::isfinite(delta) || delta <= 0) {
+          std::cerr << "Invalid argument. The argument of `--delta` should be a positive number\n";
+          return false;
+        }
         break;
+      }
       case 's':
         start = optarg;
         break;
@@ -42,13 +89,13 @@ bool arguments(int argc, char * argv[]) {
         break;
       case 'a':
         alg = optarg;
-        if (alg != "BFS" && alg != "ID" && alg != "ASTAR") {
+        if (alg != "BFS" && alg != "BIBFS" && alg != "PBFS" && alg != "ID" && alg != "IDASTAR" && alg != "ASTAR" && alg != "ALT" && alg != "CH" && alg != "DIJKSTRA" && alg != "DELTA" && alg != "HDASTAR" && alg != "LPASTAR") {
           std::cerr << "Unknown algorithm `" << alg << "`\n";
           return false;
         }
         break;
       case 'd':
-        if (!isint(optarg)) {
+        if (!path::isint(optarg)) {
           std::cerr << "Invalid argument. The argument of `-d` or `--depth` should be an integer type\n";
           return false;
         }
@@ -58,16 +105,84 @@ bool arguments(int argc, char * argv[]) {
           return false;
         }
         break;
+      case 't':
+        if (!path::isint(optarg) || std::stoi(optarg) <= 0) {
+          std::cerr << "Invalid argument. The argument of `-t` or `--threads` should be a positive integer\n";
+          return false;
+        }
+        threads = std::stoi(optarg);
+        break;
+      case 'q':
+        queries = optarg;
+        break;
+      case 'l':
+        landmarks = optarg;
+        break;
+      case 'k':
+        if (!path::isint(optarg) || std::stoi(optarg) <= 0) {
+          std::cerr << "Invalid argument. The argument of `-k` or `--count` should be a positive integer\n";
+          return false;
+        }
+        count = std::stoi(optarg);
+        break;
+      case 'c':
+        hierarchy = optarg;
+        break;
+      case 'u':
+        updates = optarg;
+        break;
+      case 'M':
+        // the option takes two files, the second is the next argument
+        sources = optarg;
+        if (optind >= argc || argv[optind][0] == '-') {
+          std::cerr << "Missing arguments. `--matrix` requires a source file and a target file\n";
+          return false;
+        }
+        targets = argv[optind++];
+        break;
+      case 'B':
+        binary = true;
+        break;
+      case 'C':
+        if (!path::isint(optarg) || std::stoll(optarg) <= 0) {
+          std::cerr << "Invalid argument. The argument of `--cache` should be a positive integer\n";
+          return false;
+        }
+        cached = std::stoll(optarg);
+        break;
       default:
         return false;
     }
   }
   
-  if (start.empty()) {
+  if (!sources.empty()) {
+    if (!start.empty() || !goal.empty() || !queries.empty() || !alg.empty()) {
+      std::cerr << "Invalid arguments. `--matrix` replaces `-s`, `-g`, `-q` and `-a`, the table holds DIJKSTRA costs\n";
+      return false;
+    }
+    alg = "DIJKSTRA";
+  }
+  if (binary && sources.empty()) {
+    std::cerr << "Invalid arguments. `--binary` only applies to `--matrix`\n";
+    return false;
+  }
+  if (!queries.empty() && (!start.empty() || !goal.empty())) {
+    std::cerr << "Invalid arguments. A query file replaces `-s` and `-g`\n";
+    return false;
+  }
+  if (queries.empty() && sources.empty() && start.empty()) {
     std::cerr << "Missing arguments. Require a start node, use `-s` or `--start to specify\n";
     return false;
   }
-  if (goal.empty()) {
+  if (alg == "DELTA" && (!queries.empty() || !goal.empty())) {
+    std::cerr << "Invalid arguments. Algorithm DELTA computes distances to every vertex, it takes no goal or query file\n";
+    return false;
+  }
+  if (alg != "DELTA" && delta != 0) {
+    std::cerr << "Invalid arguments. Algorithm " << alg << " does not use a delta\n";
+    return false;
+  }
+  if (queries.empty() && sources.empty() && goal.empty() && alg != "DELTA") {
     std::cerr << "Missing arguments. Require a goal node , use `-g` or `--goal to specify\n";
     return false;
   }
@@ -83,6 +198,26 @@ bool arguments(int argc, char * argv[]) {
     std::cerr << "Invalid arguments. Algorithm " << alg << " does not require an initial depth\n";
     return false;
   }
+  if (alg != "ALT" && (!landmarks.empty() || count != 0)) {
+    std::cerr << "Invalid arguments. Algorithm " << alg << " does not use landmarks\n";
+    return false;
+  }
+  if (alg != "LPASTAR" && !updates.empty()) {
+    std::cerr << "Invalid arguments. Algorithm " << alg << " does not replan, `-u` needs LPASTAR\n";
+    return false;
+  }
+  if (!updates.empty() && !queries.empty()) {
+    std::cerr << "Invalid arguments. An update stream replans one `-s` and `-g` pair, not a query file\n";
+    return false;
+  }
+  if (cached != 0 && queries.empty()) {
+    std::cerr << "Invalid arguments. `--cache` only applies to a query file\n";
+    return false;
+  }
+  if (alg != "CH" && !hierarchy.empty()) {
+    std::cerr << "Invalid arguments. Algorithm " << alg << " does not use a hierarchy\n";
+    return false;
+  }
   
   argc -= optind;
   argv += optind;
@@ -95,58 +230,134 @@ bool arguments(int argc, char * argv[]) {
   return true;
 }
 
-bool load_vertices(const std::string &filename, path::Graph &graph) {
-  std::ifstream in(filename);
-  
-  std::string line;
-  size_t linenum = 0;
-  while (std::getline(in, line)) {
-    ++linenum;
-    if (line.empty() || line[0] == '#') continue;
-    
-    std::istringstream ss(line);
-    std::vector<std::string> tokens;
-    std::string token;
-    while (ss >> token)
-      tokens.push_back(token);
-    
-    if (tokens.size() == 2) continue;
-    else if (tokens.size() == 3 && isint(tokens[1]) && isint(tokens[2])) {
-      graph.push_back(path::Node(tokens[0], stoi(tokens[1]), stoi(tokens[2])));
-    }
-    else {
-      std::cerr << "Invalid input file format. line " << linenum << "\n";
-      return false;
-    }
+path::Landmarks table;
+
+// reuse the landmark file if it matches the graph, otherwise build and save it
+bool prepare_landmarks(const path::Graph &graph) {
+  if (!landmarks.empty() && table.load(landmarks, graph)) {
+    if (count == 0 || count == table.size()) return true;
+  }
+  table.build(graph, count ? count : 16);
+  if (!landmarks.empty() && !table.save(landmarks)) {
+    std::cerr << "Failed to write landmark file `" << landmarks << "`\n";
+    return false;
   }
   return true;
 }
 
-bool load_edges(const std::string &filename, path::Graph &graph, std::unordered_map<std::string, size_t> &table) {
-  std::ifstream in(filename);
+path::Hierarchy contraction;
+
+// reuse the hierarchy file if it matches the graph, otherwise build and save it
+bool prepare_hierarchy(const path::Graph &graph) {
+  if (!hierarchy.empty() && contraction.load(hierarchy, graph)) return true;
+  contraction.build(graph);
+  if (!hierarchy.empty() && !contraction.save(hierarchy)) {
+    std::cerr << "Failed to write hierarchy file `" << hierarchy << "`\n";
+    return false;
+  }
+  return true;
+}
+
+path::PathSearch *make_search(const path::Graph &graph, const unsigned &threads) {
+  if (alg == "BFS")           return new path::BFS(graph);
+  else if (alg == "BIBFS")    return new path::BIBFS(graph);
+  else if (alg == "PBFS")     return new path::PBFS(graph, threads);
+  else if (alg == "ID")       return new path::ID(graph, depth, report);
+  else if (alg == "IDASTAR")  return new path::IDASTAR(graph, report);
+  else if (alg == "ALT")      return new path::ALT(graph, table);
+  else if (alg == "CH")       return new path::CH(graph, contraction);
+  else if (alg == "DIJKSTRA") return new path::DIJKSTRA(graph);
+  else if (alg == "HDASTAR")  return new path::HDASTAR(graph, threads);
+  else if (alg == "LPASTAR")  return new path::LPASTAR(graph);
+  else                        return new path::ASTAR(graph);
+}
+
+void print(const path::Path &path, const path::Graph &graph) {
+  if (path.empty())
+    std::cout << "No Solution\n";
+  else
+    std::cout << "Solution: " << path::to_string(path, graph) << "\n";
+}
+
+// one line per query on stderr so the solutions on stdout stay parseable
+void print(const size_t &s, const size_t &g, const path::Stats &stats, const path::Graph &graph) {
+  std::cerr << "Stats: " << graph.label(s) << " -> " << graph.label(g)
+            << " expanded=" << stats.expanded
+            << " relaxed=" << stats.relaxed
+            << " peak_open=" << stats.peak_open;
+  if (alg == "ID" || alg == "IDASTAR")
+    std::cerr << " rounds=" << stats.rounds << " reexpanded=" << stats.reexpanded;
+  std::cerr << " search=" << stats.seconds << "s"
+            << " peak_memory=" << path::peak_memory() << "kB\n";
+}
+
+// a label as a CSV field, quoted when it holds a separator or a quote
+std::string csv(const std::string &label) {
+  if (label.find_first_of(",\"") == std::string::npos) return label;
+  std::string s = "\"";
+  for (const char &c : label) {
+    if (c == '"') s += '"';
+    s += c;
+  }
+  return s + "\"";
+}
+
+// header row of target labels, then one row per source, `inf` if unreachable
+void print_matrix(const std::vector<size_t> &rows, const std::vector<size_t> &cols, const std::vector<double> &table, const path::Graph &graph) {
+  std::cout << std::setprecision(10);
+  for (const size_t &v : cols) std::cout << "," << csv(graph.label(v));
+  std::cout << "\n";
+  for (size_t i = 0; i < rows.size(); ++i) {
+    std::cout << csv(graph.label(rows[i]));
+    for (size_t j = 0; j < cols.size(); ++j) std::cout << "," << table[i*cols.size() + j];
+    std::cout << "\n";
+  }
+}
+
+// "PATHMTX1", rows and columns as u64, then the row-major doubles in the byte
+// order of this machine
+void write_matrix(const uint64_t &rows, const uint64_t &cols, const std::vector<double> &table) {
+  std::cout.write("PATHMTX1", 8);
+  std::cout.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+  std::cout.write(reinterpret_cast<const char *>(&cols), sizeof(cols));
+  std::cout.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(double));
+}
+
+// apply an `add`/`del`/`plan` stream to the planner, every `plan` prints the
+// path in the graph as changed so far
+bool replan(path::LPASTAR &lpa, const path::Graph &graph, const size_t &s, const size_t &g) {
+  std::ifstream file;
+  if (updates != "-") {
+    file.open(updates);
+    if (!file) {
+      std::cerr << "Failed to open update file `" << updates << "`\n";
+      return false;
+    }
+  }
+  std::istream &in = updates == "-" ? std::cin : file;
   
+  path::Stopwatch watch;
+  path::stats.clear();
   std::string line;
   size_t linenum = 0;
   while (std::getline(in, line)) {
     ++linenum;
     if (line.empty() || line[0] == '#') continue;
     
-    std::istringstream ss(line);
-    std::vector<std::string> tokens;
-    std::string token;
-    while (ss >> token)
-      tokens.push_back(token);
-    
-    if (tokens.size() == 3) continue;
-    
-    if (table.find(tokens[0]) == table.end() || table.find(tokens[1]) == table.end()) {
-      std::cerr << "Reference to vertex not in the file. line " << linenum << "\n";
-      return false;
+    path::Update update;
+    if (!path::parse_update(line, linenum, graph, update)) return false;
+    if (update.op == path::Update::add) lpa.add(update.u, update.v);
+    else if (update.op == path::Update::del) lpa.erase(update.u, update.v);
+    else {
+      path::Path path;
+      watch.lap();
+      lpa.find(s, g, path);
+      path::stats.seconds = watch.lap();
+      print(path, graph);
+      if (report) print(s, g, path::stats, graph);
+      path::stats.clear();
+      std::cout.flush();
     }
-    size_t u = table[tokens[0]], v = table[tokens[1]];
-    graph[u].adj.insert(v);
-    graph[v].adj.insert(u);
-    
   }
   return true;
 }
@@ -155,48 +366,100 @@ int main(int argc, char * argv[]) {
   if (!arguments(argc, argv)) return 1;
   
   path::Graph graph;
-  if (!load_vertices(input, graph)) return 1;
-  std::sort(graph.begin(), graph.end(), [](const path::Node &a, const path::Node &b) {
-    return a.label < b.label;
-  });
-  
-  size_t s, g;
-  {
-    std::unordered_map<std::string, size_t> table;
-    for (size_t i = 0; i < graph.size(); ++i) {
-      if (table.find(graph[i].label) != table.end()) {
-        std::cerr << "Redefinition of vertex `" << graph[i].label << "`\n";
-        return 1;
-      }
-      table[ graph[i].label ] = i;
-    }
-    if (!load_edges(input, graph, table)) return 1;
-    if (table.find(start) == table.end()) {
-      std::cerr << "Start node not in the file `" << input << "`\n";
-      return 1;
-    }
-    if (table.find(goal) == table.end()) {
-      std::cerr << "Goal node not in the file `" << input << "`\n";
-      return 1;
-    }
-    s = table[start];
-    g = table[goal];
+  path::Stopwatch watch;
+  double build = 0;
+  if (!path::load(input, graph, &build)) return 1;
+  double parse = watch.lap() - build;
+  if (alg == "ALT" && !prepare_landmarks(graph)) return 1;
+  if (alg == "CH" && !prepare_hierarchy(graph)) return 1;
+  double preprocess = watch.lap();
+  
+  if (report) {
+    std::cerr << std::fixed << std::setprecision(6);
+    std::cerr << "Stats: parse=" << parse << "s build=" << build << "s";
+    if (alg == "ALT" || alg == "CH") std::cerr << " preprocess=" << preprocess << "s";
+    std::cerr << "\n";
+  }
+  
+  if (!sources.empty()) {
+    std::vector<size_t> rows, cols;
+    if (!path::load_labels(sources, graph, rows) || !path::load_labels(targets, graph, cols)) return 1;
+    
+    // traces of concurrent searches would interleave
+    if (path::tracer.enabled()) threads = 1;
+    
+    std::vector<double> table;
+    watch.lap();
+    path::matrix(graph, rows, cols, threads, table);
+    double seconds = watch.lap();
+    
+    if (binary) write_matrix(rows.size(), cols.size(), table);
+    else        print_matrix(rows, cols, table, graph);
+    if (report) std::cerr << "Stats: " << rows.size() << "x" << cols.size() << " search=" << seconds << "s peak_memory=" << path::peak_memory() << "kB\n";
+    return 0;
+  }
+  
+  if (!queries.empty()) {
+    path::Queries batch;
+    if (!path::load_queries(queries, graph, batch)) return 1;
+    
+    // traces of concurrent searches would interleave
+    if (path::tracer.enabled()) threads = 1;
+    
+    // repeated pairs are answered from the cache shared by all workers
+    std::unique_ptr<path::PathCache> cache(cached ? new path::PathCache(cached) : nullptr);
+    
+    // the workers already run in parallel, so every search is single-threaded
+    path::batch(graph, batch, [&]() -> path::PathSearch * {
+      if (!cache) return make_search(graph, 1);
+      return new path::CachedSearch(graph, make_search(graph, 1), *cache, alg);
+    }, threads, [&](const size_t &i, const path::Path &path, const path::Stats &stats) {
+      print(path, graph);
+      if (report) print(batch[i].first, batch[i].second, stats, graph);
+    });
+    if (report && cache) std::cerr << "Stats: cache hits=" << cache->hits() << " misses=" << cache->misses() << "\n";
+    return 0;
+  }
+  
+  size_t s = graph.find(start), g = graph.find(goal);
+  if (s == path::Graph::npos) {
+    std::cerr << "Start node not in the file `" << input << "`\n";
+    return 1;
+  }
+  
+  if (alg == "DELTA") {
+    std::vector<double> dist;
+    path::DeltaStepping sssp(graph, threads, delta ? delta : path::DeltaStepping::suggest(graph));
+    watch.lap();
+    sssp.run(s, dist);
+    double seconds = watch.lap();
+    
+    std::cout << std::setprecision(10);
+    for (size_t u = 0; u < graph.size(); ++u)
+      std::cout << graph.label(u) << " " << dist[u] << "\n";
+    if (report) std::cerr << "Stats: " << start << " search=" << seconds << "s peak_memory=" << path::peak_memory() << "kB\n";
+    return 0;
   }
   
-  path::PathSearch *ps = nullptr;
-  if (alg == "BFS")     ps = new path::BFS(graph);
-  else if (alg == "ID") ps = new path::ID(graph, depth);
-  else                  ps = new path::ASTAR(graph);
+  if (g == path::Graph::npos) {
+    std::cerr << "Goal node not in the file `" << input << "`\n";
+    return 1;
+  }
+  
+  path::PathSearch *ps = make_search(graph, threads);
   
   path::Path path;
+  PATH_TRACE(path::tracer.query(graph, s, g));
+  path::stats.clear();
+  watch.lap();
   ps->find(s, g, path);
+  path::stats.seconds = watch.lap();
   
-  delete ps;
+  print(path, graph);
+  if (report) print(s, g, path::stats, graph);
   
-  if (path.empty())
-    std::cout << "No Solution\n";
-  else
-    std::cout << "Solution: " << path::to_string(path, graph) << "\n";
+  bool ok = updates.empty() || replan(*static_cast<path::LPASTAR *>(ps), graph, s, g);
+  delete ps;
   
-  return 0;
+  return ok ? 0 : 1;
 }
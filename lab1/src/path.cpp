@@ -1,20 +1,250 @@
 #include "path.hpp"
+#include "tracing.hpp"
+#include "stats.hpp"
 #include <cmath>
-#include <queue>
 #include <algorithm>
-
-std::ostream path::verbose(nullptr);
+#include <limits>
+#include <fstream>
+#include <cstring>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // constructors & destructors
-path::Node::Node(const std::string &label, const int& x, const int& y) : label(label), x(x), y(y) {}
+
+const char path::Graph::magic[8] = {'P', 'A', 'T', 'H', 'G', 'R', 'F', '2'};
+const size_t path::Graph::npos;
+
+namespace {
+
+// source of Graph generations, unique over all graphs of the process
+std::atomic<uint64_t> generations(0);
+
+}
+
+path::Graph::Graph() : mapping(nullptr), mapped(0) {
+  build(Nodes(), std::string(), Edges());
+}
+
+path::Graph::~Graph() {
+  release();
+}
+
+// byte offsets of the six sections after the header, returns the image size,
+// the 8-byte sections come first so every section stays aligned
+size_t path::Graph::layout(const Header &header, size_t section[6]) {
+  section[0] = sizeof(Header);
+  section[1] = section[0] + (header.n+1) * sizeof(uint64_t);
+  section[2] = section[1] + (header.n+1) * sizeof(uint64_t);
+  section[3] = section[2] + (header.costs == euclidean ? 0 : header.m * sizeof(double));
+  section[4] = section[3] + header.n * sizeof(int32_t);
+  section[5] = section[4] + header.n * sizeof(int32_t);
+  size_t labels = section[5] + header.m * sizeof(uint32_t);
+  return labels + header.label_bytes;
+}
+
+bool path::Graph::bind(const char *data, const size_t &size) {
+  if (size < sizeof(Header)) return false;
+  const Header &header = *reinterpret_cast<const Header *>(data);
+  if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) return false;
+  if (header.costs > integer) return false;
+  // a vertex takes more than a byte of the image, an arc four and the labels
+  // their bytes, so the counts of a header that passes cannot wrap the layout
+  if (header.n >= size || header.m > size / sizeof(uint32_t) || header.label_bytes > size) return false;
+  
+  size_t section[6];
+  if (layout(header, section) > size) return false;
+  
+  const uint64_t *offset = reinterpret_cast<const uint64_t *>(data + section[0]);
+  const uint64_t *label_offset = reinterpret_cast<const uint64_t *>(data + section[1]);
+  if (offset[header.n] != header.m || label_offset[header.n] != header.label_bytes) return false;
+  
+  base = data;
+  bytes = layout(header, section);
+  n = header.n;
+  m = header.m;
+  kind = Costs(header.costs);
+  this->offset = offset;
+  this->label_offset = label_offset;
+  weights = kind == euclidean ? nullptr : reinterpret_cast<const double *>(data + section[2]);
+  xs = reinterpret_cast<const int32_t *>(data + section[3]);
+  ys = reinterpret_cast<const int32_t *>(data + section[4]);
+  targets = reinterpret_cast<const uint32_t *>(data + section[5]);
+  labels = data + section[5] + m * sizeof(uint32_t);
+  gen = ++generations;
+  return true;
+}
+
+void path::Graph::release() {
+  if (mapping) munmap(mapping, mapped);
+  mapping = nullptr;
+  mapped = 0;
+  std::vector<uint64_t>().swap(image);
+}
+
+void path::Graph::build(const Nodes &nodes, const std::string &arena, const Edges &edges, const Weights &weights) {
+  typedef std::pair<uint32_t, double> Arc;
+  std::vector<uint64_t> offset(nodes.size()+1, 0);
+  std::vector<Arc> arcs;
+  
+  // count degrees, every edge is stored in both directions
+  for (const auto &e : edges) {
+    ++offset[e.first+1];
+    if (e.first != e.second) ++offset[e.second+1];
+  }
+  for (size_t u = 0; u < nodes.size(); ++u)
+    offset[u+1] += offset[u];
+  
+  arcs.resize(offset.back());
+  std::vector<uint64_t> fill(offset.begin(), offset.end()-1);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    const auto &e = edges[i];
+    double w = weights.empty() ? 0 : weights[i];
+    arcs[fill[e.first]++] = Arc(e.second, w);
+    if (e.first != e.second) arcs[fill[e.second]++] = Arc(e.first, w);
+  }
+  
+  // sort every row and drop duplicated edges, compacting in place, the
+  // cheapest copy of an edge sorts first and is the one kept
+  size_t k = 0;
+  for (size_t u = 0; u < nodes.size(); ++u) {
+    auto first = arcs.begin() + offset[u], last = arcs.begin() + offset[u+1];
+    std::sort(first, last);
+    last = std::unique(first, last, [](const Arc &a, const Arc &b) { return a.first == b.first; });
+    offset[u] = k;
+    k = std::copy(first, last, arcs.begin() + k) - arcs.begin();
+  }
+  offset.back() = k;
+  
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.n = nodes.size();
+  header.m = k;
+  header.label_bytes = 0;
+  for (const Node &node : nodes) header.label_bytes += node.length;
+  header.costs = euclidean;
+  if (!weights.empty()) {
+    // whole costs below 2^53 are exact in a double and fit a radix heap key
+    header.costs = integer;
+    for (size_t i = 0; i < k; ++i) {
+      if (arcs[i].second != std::floor(arcs[i].second) || arcs[i].second >= 9007199254740992.0) {
+        header.costs = real;
+        break;
+      }
+    }
+  }
+  
+  size_t section[6];
+  size_t bytes = layout(header, section);
+  
+  release();
+  image.assign((bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+  char *base = reinterpret_cast<char *>(image.data());
+  
+  std::memcpy(base, &header, sizeof(Header));
+  std::memcpy(base + section[0], offset.data(), offset.size() * sizeof(uint64_t));
+  
+  double *costs = reinterpret_cast<double *>(base + section[2]);
+  uint32_t *targets = reinterpret_cast<uint32_t *>(base + section[5]);
+  for (size_t i = 0; i < k; ++i) {
+    if (header.costs != euclidean) costs[i] = arcs[i].second;
+    targets[i] = arcs[i].first;
+  }
+  
+  uint64_t *label_offset = reinterpret_cast<uint64_t *>(base + section[1]);
+  int32_t *xs = reinterpret_cast<int32_t *>(base + section[3]);
+  int32_t *ys = reinterpret_cast<int32_t *>(base + section[4]);
+  char *labels = base + section[5] + k * sizeof(uint32_t);
+  label_offset[0] = 0;
+  for (size_t u = 0; u < nodes.size(); ++u) {
+    xs[u] = nodes[u].x;
+    ys[u] = nodes[u].y;
+    std::memcpy(labels + label_offset[u], arena.data() + nodes[u].label, nodes[u].length);
+    label_offset[u+1] = label_offset[u] + nodes[u].length;
+  }
+  
+  bind(base, bytes);
+}
+
+bool path::Graph::open(const std::string &filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  
+  struct stat st;
+  void *addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return false;
+  
+  // bind leaves the current image untouched if the file is not valid
+  if (!bind(static_cast<const char *>(addr), st.st_size)) {
+    munmap(addr, st.st_size);
+    return false;
+  }
+  release();
+  mapping = addr;
+  mapped = st.st_size;
+  return true;
+}
+
+bool path::Graph::save(const std::string &filename) const {
+  std::ofstream out(filename, std::ios::binary);
+  out.write(base, bytes);
+  return bool(out);
+}
+
+uint64_t path::Graph::checksum() const {
+  uint64_t h = 0xcbf29ce484222325ull;
+  size_t i = 0;
+  for (; i + 8 <= bytes; i += 8) {
+    uint64_t w;
+    std::memcpy(&w, base + i, 8);
+    h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 32;
+  }
+  for (; i < bytes; ++i) h = (h ^ (unsigned char)base[i]) * 0x100000001b3ull;
+  return h;
+}
+
+bool path::Graph::packed(const std::string &filename) {
+  std::ifstream in(filename, std::ios::binary);
+  // the last magic byte is the format version, older versions are still
+  // recognized as packed so that open() reports them instead of the text parser
+  char buf[sizeof(magic)];
+  return in.read(buf, sizeof(buf)) && std::memcmp(buf, magic, sizeof(magic)-1) == 0;
+}
+
+size_t path::Graph::find(const std::string &label) const {
+  size_t lo = 0, hi = n;
+  while (lo < hi) {
+    size_t mid = lo + (hi-lo) / 2;
+    const char *p = labels + label_offset[mid];
+    size_t len = label_offset[mid+1] - label_offset[mid];
+    int c = std::memcmp(p, label.data(), std::min(len, label.size()));
+    if (c == 0) c = len < label.size() ? -1 : len > label.size();
+    if (c == 0) return mid;
+    if (c < 0) lo = mid+1;
+    else hi = mid;
+  }
+  return npos;
+}
 
 path::PathSearch::PathSearch(const Graph &graph) : G(graph) {}
 
 path::BFS::BFS(const Graph &graph) : PathSearch(graph) {}
 
-path::ID::ID(const Graph &graph, const int& depth) : PathSearch(graph), maxdepth(depth) {}
+path::BIBFS::BIBFS(const Graph &graph) : PathSearch(graph) {}
+
+path::ID::ID(const Graph &graph, const int& depth, const bool &reexpansions) : PathSearch(graph), initial(depth), maxdepth(depth), reexpansions(reexpansions) {}
+
+path::IDASTAR::IDASTAR(const Graph &graph, const bool &reexpansions) : PathSearch(graph), reexpansions(reexpansions) {}
 
-path::ASTAR::ASTAR(const Graph &graph) : PathSearch(graph) {}
+path::ASTAR::ASTAR(const Graph &graph) : PathSearch(graph), Q(graph.size()) {}
+
+path::DIJKSTRA::DIJKSTRA(const Graph &graph) : PathSearch(graph), Q(graph.size()) {}
 
 path::PathSearch::~PathSearch() {}
 
@@ -22,9 +252,9 @@ path::PathSearch::~PathSearch() {}
 std::string path::to_string(const path::Path &path, const path::Graph &graph) {
   std::string s;
   if (!path.empty()) {
-    s += graph[path[0]].label;
+    s += graph.label(path[0]);
     for (size_t i = 1; i < path.size(); ++i) {
-      s += " -> " + graph[path[i]].label;
+      s += " -> " + graph.label(path[i]);
     }
   }
   return s;
@@ -32,38 +262,86 @@ std::string path::to_string(const path::Path &path, const path::Graph &graph) {
 
 // member funcs
 void path::BFS::find(const size_t &s, const size_t &g, Path &path) {
-  std::vector<bool> visited(G.size());
-  std::vector<size_t> prev(G.size(), -1);
-  std::queue<size_t> Q({s});
-  visited[s] = true;
+  // a vertex is visited once it has a parent entry, s gets the root marker
+  prev.reset(G.size(), -1);
+  prev.set(s, -1);
+  queue.assign(1, s);
   
-  while (!Q.empty()) {
-    size_t cur = Q.front();
-    Q.pop();
+  for (size_t head = 0; head < queue.size(); ++head) {
+    size_t cur = queue[head];
     if (cur == g) break;
     
-    verbose << "Expanding: " << G[cur].label << "\n";
+    PATH_TRACE(tracer.expand(G, cur, "Expanding: "));
+    ++stats.expanded;
     
-    for (const size_t &next : G[cur].adj) {
-      if (visited[next]) continue;
-      visited[next] = true;
-      Q.push(next);
-      prev[next] = cur;
+    for (const size_t next : G.adj(cur)) {
+      ++stats.relaxed;
+      if (prev.contains(next)) continue;
+      prev.set(next, cur);
+      queue.push_back(next);
     }
+    stats.open(queue.size() - head - 1);
   }
   
   if (prev[g] == (size_t)-1) return;
   
-  size_t cur = g;
-  while (cur != (size_t)-1) {
-    path.push_back(cur);
-    cur = prev[cur];
+  trace(prev, g, path);
+}
+
+void path::BIBFS::find(const size_t &s, const size_t &g, Path &path) {
+  if (s == g) {
+    path.push_back(s);
+    return;
   }
-  std::reverse(path.begin(), path.end());
+  
+  // side 0 searches from s, side 1 from g
+  for (int d = 0; d < 2; ++d) {
+    depth[d].reset(G.size(), -1);
+    prev[d].reset(G.size(), -1);
+    frontier[d].clear();
+  }
+  frontier[0].push_back(s);
+  frontier[1].push_back(g);
+  depth[0].set(s, 0);
+  depth[1].set(g, 0);
+  
+  size_t best = -1, meet[2] = {};
+  while (!frontier[0].empty() && !frontier[1].empty()) {
+    int d = frontier[0].size() <= frontier[1].size() ? 0 : 1, o = 1-d;
+    
+    // finish the whole level so the shortest crossing edge is picked
+    next_frontier.clear();
+    for (const size_t &cur : frontier[d]) {
+      PATH_TRACE(tracer.expand(G, cur, "Expanding: "));
+      ++stats.expanded;
+      
+      for (const size_t next : G.adj(cur)) {
+        ++stats.relaxed;
+        if (depth[o][next] != (size_t)-1 && depth[d][cur]+1+depth[o][next] < best) {
+          best = depth[d][cur]+1+depth[o][next];
+          meet[d] = cur;
+          meet[o] = next;
+        }
+        if (depth[d][next] != (size_t)-1) continue;
+        depth[d].set(next, depth[d][cur]+1);
+        prev[d].set(next, cur);
+        next_frontier.push_back(next);
+      }
+    }
+    frontier[d].swap(next_frontier);
+    stats.open(frontier[0].size() + frontier[1].size());
+    if (best != (size_t)-1) break;
+  }
+  
+  if (best == (size_t)-1) return;
+  
+  trace(prev[0], meet[0], path);
+  for (size_t cur = meet[1]; cur != (size_t)-1; cur = prev[1][cur])
+    path.push_back(cur);
 }
 
-bool path::ID::visit(std::vector<bool> &visited, const size_t &u, const size_t &g, const int &depth, Path &path) {
-  visited[u] = true;
+bool path::ID::visit(const size_t &u, const size_t &g, const int &depth, Path &path) {
+  visited.insert(u);
   
   if (u == g) {
     path.push_back(u);
@@ -71,17 +349,24 @@ bool path::ID::visit(std::vector<bool> &visited, const size_t &u, const size_t &
   }
   
   if (depth == maxdepth) {
-    verbose << "hit depth=" << depth << ": " << G[u].label << "\n";
+    PATH_TRACE(tracer.hit(G, u, depth));
     hit = true;
     return false;
   }
   
-  verbose << "Expand: " << G[u].label << "\n";
+  PATH_TRACE(tracer.expand(G, u, "Expand: "));
+  ++stats.expanded;
+  if (reexpansions) {
+    if (expanded.contains(u)) ++stats.reexpanded;
+    else expanded.insert(u);
+  }
+  stats.open(depth+1);
   
-  for (const size_t &v : G[u].adj) {
-    if (visited[v]) continue;
+  for (const size_t v : G.adj(u)) {
+    ++stats.relaxed;
+    if (visited.contains(v)) continue;
     
-    if (visit(visited, v, g, depth+1, path)) {
+    if (visit(v, g, depth+1, path)) {
       path.push_back(u);
       return true;
     }
@@ -90,55 +375,185 @@ bool path::ID::visit(std::vector<bool> &visited, const size_t &u, const size_t &
 }
 
 void path::ID::find(const size_t &s, const size_t &g, Path &path) {
+  maxdepth = initial;
   hit = true;
+  if (reexpansions) expanded.reset(G.size());
   while (hit) {
     hit = false;
-    std::vector<bool> visited(G.size());
-    if (visit(visited, s, g, 0, path)) break;
+    ++stats.rounds;
+    visited.reset(G.size());
+    if (visit(s, g, 0, path)) break;
     ++maxdepth;
   }
   std::reverse(path.begin(), path.end());
 }
 
-double path::ASTAR::dist(const size_t &u, const size_t &v) {
-  return std::sqrt(std::pow(G[u].x-G[v].x, 2) + std::pow(G[u].y-G[v].y, 2));
+bool path::IDASTAR::visit(const size_t &u, const size_t &g, const double &gval, Path &path) {
+  double f = gval + dist(u, g);
+  if (f > bound) {
+    PATH_TRACE(tracer.hit(G, u, f));
+    next_bound = std::min(next_bound, f);
+    return false;
+  }
+  
+  if (u == g) {
+    path.push_back(u);
+    return true;
+  }
+  
+  PATH_TRACE(tracer.expand(G, u, "Expand: "));
+  ++stats.expanded;
+  if (reexpansions) {
+    if (expanded.contains(u)) ++stats.reexpanded;
+    else expanded.insert(u);
+  }
+  
+  onpath.insert(u);
+  stats.open(++depth);
+  for (const size_t v : G.adj(u)) {
+    ++stats.relaxed;
+    if (onpath.count(v)) continue;
+    
+    if (visit(v, g, gval + dist(u, v), path)) {
+      path.push_back(u);
+      return true;
+    }
+  }
+  onpath.erase(u);
+  --depth;
+  return false;
+}
+
+void path::IDASTAR::find(const size_t &s, const size_t &g, Path &path) {
+  static const double inf = std::numeric_limits<double>::infinity();
+  
+  onpath.clear();
+  if (reexpansions) expanded.reset(G.size());
+  bound = dist(s, g);
+  while (true) {
+    // the smallest f that exceeded the bound becomes the next bound
+    next_bound = inf;
+    depth = 0;
+    ++stats.rounds;
+    if (visit(s, g, 0, path)) break;
+    if (next_bound == inf) return;
+    PATH_TRACE(tracer.bound(next_bound));
+    bound = next_bound;
+  }
+  std::reverse(path.begin(), path.end());
 }
 
 void path::ASTAR::find(const size_t &s, const size_t &g, Path &path) {
-  typedef std::pair<double, Path> Record;
+  static const double inf = std::numeric_limits<double>::infinity();
   
-  auto cmp = [](const Record &a, const Record &b) {
-    return a.first > b.first;
-  };
-  std::priority_queue<Record, std::vector<Record>, decltype(cmp)> Q(cmp);
+  gval.reset(G.size(), inf);
+  prev.reset(G.size(), -1);
+  closed.reset(G.size());
+  Q.clear();
   
-  Q.push({dist(s, g), {s}});
+  gval.set(s, 0);
+  Q.push(s, h(s, g));
   
   while (!Q.empty()) {
-    Path cur_path = Q.top().second;
-    double cur_val = Q.top().first;
-    Q.pop();
+    size_t cur = Q.pop();
+    closed.insert(cur);
+    if (cur == g) break;
+    
+    if (cur != s) PATH_TRACE(tracer.expand(G, prev, cur));
+    ++stats.expanded;
     
-    if (cur_path.back() == g) {
-      path = std::move(cur_path);
-      break;
+    for (const size_t next : G.adj(cur)) {
+      ++stats.relaxed;
+      double gnext = gval[cur] + dist(cur, next);
+      double hnext = h(next, g);
+      
+      PATH_TRACE(tracer.relax(G, cur, next, gnext, hnext));
+      
+      if (closed.contains(next) || gnext >= gval[next]) continue;
+      gval.set(next, gnext);
+      prev.set(next, cur);
+      Q.push(next, gnext+hnext);
     }
+    stats.open(Q.size());
+  }
+  
+  if (closed.contains(g)) trace(prev, g, path);
+}
+
+// the radix heap has no decrease-key, so a vertex may be queued several times,
+// copies that come out after the vertex was settled are skipped
+template <typename Queue, typename Done>
+void path::DIJKSTRA::search(Queue &queue, const size_t &s, const Done &done) {
+  gval.set(s, 0);
+  queue.push(s, 0);
+  
+  while (!queue.empty()) {
+    size_t cur = queue.pop();
+    if (closed.contains(cur)) continue;
+    closed.insert(cur);
+    if (done(cur)) break;
     
-    if (cur_path.size() > 1)
-      verbose << "adding " << to_string(cur_path, G) << "\n";
+    if (cur != s) PATH_TRACE(tracer.expand(G, prev, cur));
+    ++stats.expanded;
     
-    for (const size_t &next : G[cur_path.back()].adj) {
-      double gval = cur_val - dist(cur_path.back(),g) + dist(cur_path.back(), next);
-      double hval = dist(next, g);
+    Span<uint32_t> adj = G.adj(cur);
+    const double *cost = G.weighted() ? G.costs(cur).begin() : nullptr;
+    for (size_t i = 0; i < adj.size(); ++i) {
+      ++stats.relaxed;
+      size_t next = adj.begin()[i];
+      double gnext = gval[cur] + (cost ? cost[i] : dist(cur, next));
       
-      verbose << G[cur_path.back()].label << " -> " << G[next].label << " ; g=" << gval << " h=" << hval << " = " << gval+hval << "\n";
+      PATH_TRACE(tracer.relax(G, cur, next, gnext, 0));
       
-      if (std::find(cur_path.begin(), cur_path.end(), next) == cur_path.end()) {
-        Path next_path;
-        next_path.insert(next_path.end(), cur_path.begin(), cur_path.end());
-        next_path.push_back(next);
-        Q.push({gval+hval, next_path});
-      }
+      if (closed.contains(next) || gnext >= gval[next]) continue;
+      gval.set(next, gnext);
+      prev.set(next, cur);
+      queue.push(next, gnext);
     }
+    stats.open(queue.size());
+  }
+}
+
+template <typename Done>
+void path::DIJKSTRA::search(const size_t &s, const Done &done) {
+  static const double inf = std::numeric_limits<double>::infinity();
+  
+  gval.reset(G.size(), inf);
+  prev.reset(G.size(), -1);
+  closed.reset(G.size());
+  
+  if (G.integral()) {
+    R.clear();
+    search(R, s, done);
   }
+  else {
+    Q.clear();
+    search(Q, s, done);
+  }
+}
+
+void path::DIJKSTRA::find(const size_t &s, const size_t &g, Path &path) {
+  search(s, [&](const size_t &u) { return u == g; });
+  if (closed.contains(g)) trace(prev, g, path);
+}
+
+void path::DIJKSTRA::distances(const size_t &s, const std::vector<size_t> &targets, double *out) {
+  static const double inf = std::numeric_limits<double>::infinity();
+  
+  wanted.reset(G.size());
+  size_t left = 0;
+  for (const size_t &t : targets) {
+    if (!wanted.contains(t)) ++left;
+    wanted.insert(t);
+  }
+  if (left == 0) return;
+  
+  search(s, [&](const size_t &u) {
+    if (!wanted.contains(u)) return false;
+    wanted.erase(u);
+    return --left == 0;
+  });
+  
+  for (size_t i = 0; i < targets.size(); ++i)
+    out[i] = closed.contains(targets[i]) ? gval[targets[i]] : inf;
 }
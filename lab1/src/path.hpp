@@ -2,7 +2,13 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <set>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include "heap.hpp"
+#include "scratch.hpp"
 
 #ifndef path_hpp
 #define path_hpp
@@ -10,24 +16,159 @@
 namespace path {
 
 struct Node;
-typedef std::vector<Node> Graph;
+class Graph;
+typedef std::vector<Node> Nodes;
+typedef std::vector<std::pair<size_t, size_t>> Edges;
+typedef std::vector<double> Weights;
 typedef std::vector<size_t> Path;
+typedef std::vector<std::pair<size_t, size_t>> Queries;
 
+// a parsed vertex, its label is the slice [label, label+length) of the label
+// arena that goes with the vertex list
 struct Node {
-  std::string label;
-  int x, y;
-  std::set<size_t> adj;
-  Node(const std::string &label, const int& x, const int& y);
+  uint64_t label;
+  uint32_t length;
+  int32_t x, y;
 };
 
-extern std::ostream verbose;
+// contiguous, read-only view over a run of elements
+template <typename T>
+struct Span {
+  const T *first, *last;
+  const T *begin() const { return first; }
+  const T *end() const { return last; }
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+};
+
+// frozen compressed-sparse-row graph, neighbours of every vertex are sorted
+// and vertices are sorted by label
+//
+// all data lives in one image with the layout of the packed file format,
+//   header | offset[n+1] | label_offset[n+1] | costs[m] | x[n] | y[n] | targets[m] | labels
+// either owned in memory or mapped read-only from a file written by save(),
+// the costs section is empty unless the input gave edge weights
+class Graph {
+private:
+  enum Costs : uint64_t { euclidean, real, integer };
+  
+  struct Header {
+    char magic[8];
+    uint64_t n, m, label_bytes;
+    uint64_t costs;
+  };
+  
+  static const char magic[8];
+  
+  std::vector<uint64_t> image;
+  void *mapping;
+  size_t mapped;
+  
+  const char *base;
+  size_t bytes;
+  size_t n, m;
+  Costs kind;
+  const uint64_t *offset, *label_offset;
+  const double *weights;
+  const int32_t *xs, *ys;
+  const uint32_t *targets;
+  const char *labels;
+  uint64_t gen;
+  
+  static size_t layout(const Header &header, size_t section[6]);
+  
+  bool bind(const char *base, const size_t &bytes);
+  
+  void release();
+  
+public:
+  static const size_t npos = -1;
+  
+  Graph();
+  
+  Graph(const Graph &) = delete;
+  
+  Graph &operator=(const Graph &) = delete;
+  
+  ~Graph();
+  
+  // `nodes` must be sorted by label and their labels point into `arena`,
+  // `weights` is either empty or gives the cost of every edge, duplicated
+  // edges keep the cheapest one
+  void build(const Nodes &nodes, const std::string &arena, const Edges &edges, const Weights &weights = Weights());
+  
+  // map a packed graph file, returns false if it is not one
+  bool open(const std::string &filename);
+  
+  bool save(const std::string &filename) const;
+  
+  static bool packed(const std::string &filename);
+  
+  // changes every time the graph is built or opened, results derived from an
+  // older generation are stale
+  uint64_t generation() const { return gen; }
+  
+  // hash of the whole image, labels, coordinates, arcs and costs, files
+  // derived from one graph store it to recognize that graph again
+  uint64_t checksum() const;
+  
+  size_t size() const { return n; }
+  
+  size_t edges() const { return m; }
+  
+  std::string label(const size_t &u) const {
+    return std::string(labels + label_offset[u], labels + label_offset[u+1]);
+  }
+  
+  // binary search over the sorted labels, npos if not found
+  size_t find(const std::string &label) const;
+  
+  int x(const size_t &u) const { return xs[u]; }
+  
+  int y(const size_t &u) const { return ys[u]; }
+  
+  // straight-line distance, the edge cost used by the A* family
+  double dist(const size_t &a, const size_t &b) const {
+    return std::sqrt(std::pow(x(a)-x(b), 2) + std::pow(y(a)-y(b), 2));
+  }
+  
+  Span<uint32_t> adj(const size_t &u) const {
+    return {targets + offset[u], targets + offset[u+1]};
+  }
+  
+  // the input gave explicit edge costs, only then costs() is valid
+  bool weighted() const { return kind != euclidean; }
+  
+  // every explicit cost is a whole number
+  bool integral() const { return kind == integer; }
+  
+  // costs of the arcs of u, parallel to adj(u)
+  Span<double> costs(const size_t &u) const {
+    return {weights + offset[u], weights + offset[u+1]};
+  }
+};
 
 std::string to_string(const path::Path &path, const path::Graph &graph);
 
+// rebuild the path ending at u by following parent pointers
+template <typename Parents>
+void trace(const Parents &prev, size_t u, Path &path) {
+  path.clear();
+  while (u != (size_t)-1) {
+    path.push_back(u);
+    u = prev[u];
+  }
+  std::reverse(path.begin(), path.end());
+}
+
+// an instance keeps its scratch space between calls to find and clears it in
+// O(1), so reuse one instance per thread for many queries
 class PathSearch {
 protected:
   const Graph &G;
   
+  double inline dist(const size_t& a, const size_t &b) const { return G.dist(a, b); }
+  
 public:
   PathSearch(const Graph &graph);
   
@@ -37,33 +178,107 @@ public:
 };
 
 class BFS : public PathSearch {
+private:
+  StampedArray<size_t> prev;
+  std::vector<size_t> queue;
+  
 public:
   BFS(const Graph &graph);
   
   void find(const size_t &s, const size_t &g, Path &path) override;
 };
 
+// grows one BFS frontier from each end, always advancing the smaller one
+class BIBFS : public PathSearch {
+private:
+  StampedArray<size_t> depth[2], prev[2];
+  std::vector<size_t> frontier[2], next_frontier;
+  
+public:
+  BIBFS(const Graph &graph);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
 class ID : public PathSearch {
 private:
+  const int initial;
   int maxdepth;
   bool hit;
+  StampedSet visited;
+  const bool reexpansions;
+  StampedSet expanded;  // over all rounds, kept only to count re-expansions
+  
+  bool visit(const size_t &u, const size_t &g, const int &depth, Path &path);
+public:
+  // reexpansions keeps a set of every expanded vertex to fill stats.reexpanded
+  ID(const Graph &graph, const int &depth, const bool &reexpansions = false);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+// iterative deepening on f = g + h, cycles are checked against the vertices
+// of the current path only, so memory stays linear in the path length
+class IDASTAR : public PathSearch {
+private:
+  double bound, next_bound;
+  size_t depth;
+  std::unordered_set<size_t> onpath;
+  const bool reexpansions;
+  StampedSet expanded;  // over all rounds, kept only to count re-expansions
   
-  bool visit(std::vector<bool> &visited, const size_t &u, const size_t &g, const int &depth, Path &path);
+  bool visit(const size_t &u, const size_t &g, const double &gval, Path &path);
 public:
-  ID(const Graph &graph, const int &depth);
+  // reexpansions keeps a set of every expanded vertex to fill stats.reexpanded,
+  // which makes the memory linear in the graph size again
+  IDASTAR(const Graph &graph, const bool &reexpansions = false);
   
   void find(const size_t &s, const size_t &g, Path &path) override;
 };
 
 class ASTAR : public PathSearch {
 private:
-  double inline dist(const size_t& a, const size_t &b);
+  StampedArray<double> gval;
+  StampedArray<size_t> prev;
+  StampedSet closed;
+  IndexedHeap<double> Q;
+  
+protected:
+  // lower bound on the cost from u to g, straight-line distance by default
+  virtual double h(const size_t &u, const size_t &g) { return dist(u, g); }
   
 public:
   ASTAR(const Graph &graph);
   
   void find(const size_t &s, const size_t &g, Path &path) override;
 };
+
+// uniform-cost search on the edge costs of the input, the straight-line
+// distance if it gave none. Integer costs go through a radix heap
+class DIJKSTRA : public PathSearch {
+private:
+  StampedArray<double> gval;
+  StampedArray<size_t> prev;
+  StampedSet closed, wanted;
+  IndexedHeap<double> Q;
+  RadixHeap<uint32_t> R;
+  
+  // settles vertices in cost order until done(u) is true for a settled u
+  template <typename Queue, typename Done>
+  void search(Queue &queue, const size_t &s, const Done &done);
+  
+  template <typename Done>
+  void search(const size_t &s, const Done &done);
+  
+public:
+  DIJKSTRA(const Graph &graph);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+  
+  // costs from s to every vertex of `targets` into out[0..targets.size()),
+  // infinity if unreachable, one search that stops once all are settled
+  void distances(const size_t &s, const std::vector<size_t> &targets, double *out);
+};
 }
 
 #endif /* path_hpp */
@@ -0,0 +1,207 @@
+#include "path.hpp"
+#include "pbfs.hpp"
+#include "graphio.hpp"
+#include "alt.hpp"
+#include "ch.hpp"
+#include "stats.hpp"
+#include "hda.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <iomanip>
+#include <thread>
+#include <cmath>
+#include <getopt.h>
+
+// times path searches over random query pairs, one JSON object per algorithm
+// on standard output so runs can be compared over time
+std::string algs = "BFS,BIBFS,ASTAR,DIJKSTRA", input;
+size_t queries = 1000;
+uint64_t seed = 1;
+int depth = 0;
+unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+bool arguments(int argc, char * argv[]) {
+  const option options[] = {
+    {"alg",     required_argument, nullptr, 'a'},
+    {"queries", required_argument, nullptr, 'n'},
+    {"seed",    required_argument, nullptr, 'r'},
+    {"depth",   required_argument, nullptr, 'd'},
+    {"threads", required_argument, nullptr, 't'},
+    {nullptr,   no_argument,       nullptr,  0}
+  };
+  
+  int c = 0, idx = 0;
+  while ((c = getopt_long(argc, argv, "a:n:r:d:t:", options, &idx)) != -1) {
+    switch (c) {
+      case 'a':
+        algs = optarg;
+        break;
+      case 'n':
+        if (!path::isint(optarg) || std::stoll(optarg) <= 0) {
+          std::cerr << "Invalid argument. The argument of `-n` or `--queries` should be a positive integer\n";
+          return false;
+        }
+        queries = std::stoll(optarg);
+        break;
+      case 'r':
+        if (!path::isint(optarg)) {
+          std::cerr << "Invalid argument. The argument of `-r` or `--seed` should be an integer\n";
+          return false;
+        }
+        seed = std::stoll(optarg);
+        break;
+      case 'd':
+        if (!path::isint(optarg) || std::stoi(optarg) <= 0) {
+          std::cerr << "Invalid argument. The argument of `-d` or `--depth` should be a positive integer\n";
+          return false;
+        }
+        depth = std::stoi(optarg);
+        break;
+      case 't':
+        if (!path::isint(optarg) || std::stoi(optarg) <= 0) {
+          std::cerr << "Invalid argument. The argument of `-t` or `--threads` should be a positive integer\n";
+          return false;
+        }
+        threads = std::stoi(optarg);
+        break;
+      default:
+        return false;
+    }
+  }
+  
+  argc -= optind;
+  argv += optind;
+  
+  if (argc != 1) {
+    std::cerr << (argc < 1 ? "Too few" : "Too many") << " arguments. Usage: pathbench [-a <alg,...>] [-n <queries>] [-r <seed>] [-d <depth>] [-t <threads>] <input_file>\n";
+    return false;
+  }
+  input = argv[0];
+  return true;
+}
+
+path::Landmarks table;
+path::Hierarchy contraction;
+
+// the search for one algorithm, nullptr if it is unknown or not usable here,
+// preprocessing is built in memory and its time goes to `preprocess`
+path::PathSearch *make_search(const std::string &alg, const path::Graph &graph, double &preprocess) {
+  path::Stopwatch watch;
+  preprocess = 0;
+  if (alg == "BFS")           return new path::BFS(graph);
+  else if (alg == "BIBFS")    return new path::BIBFS(graph);
+  else if (alg == "PBFS")     return new path::PBFS(graph, threads);
+  else if (alg == "IDASTAR")  return new path::IDASTAR(graph);
+  else if (alg == "ASTAR")    return new path::ASTAR(graph);
+  else if (alg == "DIJKSTRA") return new path::DIJKSTRA(graph);
+  else if (alg == "HDASTAR")  return new path::HDASTAR(graph, threads);
+  else if (alg == "ID") {
+    if (depth == 0) {
+      std::cerr << "Missing arguments. Algorithm ID requires an initial depth, use `-d` or `--depth to specify\n";
+      return nullptr;
+    }
+    return new path::ID(graph, depth);
+  }
+  else if (alg == "ALT") {
+    if (table.size() == 0) table.build(graph, 16);
+    preprocess = watch.lap();
+    return new path::ALT(graph, table);
+  }
+  else if (alg == "CH") {
+    contraction.build(graph);
+    preprocess = watch.lap();
+    return new path::CH(graph, contraction);
+  }
+  std::cerr << "Unknown algorithm `" << alg << "`\n";
+  return nullptr;
+}
+
+// nearest-rank percentile of sorted samples
+double percentile(const std::vector<double> &sorted, const double &p) {
+  size_t rank = std::ceil(p * sorted.size());
+  return sorted[rank ? rank-1 : 0];
+}
+
+// a JSON string literal, only quotes, backslashes and control characters need escaping
+std::string json(const std::string &s) {
+  std::ostringstream out;
+  out << '"';
+  for (const char &c : s) {
+    if (c == '"' || c == '\\') out << '\\' << c;
+    else if ((unsigned char)c < 0x20) out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+    else out << c;
+  }
+  out << '"';
+  return out.str();
+}
+
+int main(int argc, char * argv[]) {
+  if (!arguments(argc, argv)) return 1;
+  
+  path::Graph graph;
+  if (!path::load(input, graph)) return 1;
+  if (graph.size() == 0) {
+    std::cerr << "Empty graph `" << input << "`\n";
+    return 1;
+  }
+  
+  // every algorithm answers the same pairs
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<size_t> vertex(0, graph.size()-1);
+  path::Queries pairs;
+  while (pairs.size() < queries) {
+    size_t s = vertex(rng), g = vertex(rng);
+    if (s != g || graph.size() == 1) pairs.push_back({s, g});
+  }
+  
+  std::istringstream list(algs);
+  std::string alg;
+  std::cout << std::fixed << std::setprecision(3);
+  while (std::getline(list, alg, ',')) {
+    double preprocess = 0;
+    path::PathSearch *ps = make_search(alg, graph, preprocess);
+    if (!ps) return 1;
+  
+    std::vector<double> micros;
+    micros.reserve(pairs.size());
+    uint64_t solved = 0, expanded = 0;
+    double total = 0;
+    path::Path path;
+    path::Stopwatch watch;
+    for (const auto &q : pairs) {
+      path::stats.clear();
+      path.clear();
+      watch.lap();
+      ps->find(q.first, q.second, path);
+      double seconds = watch.lap();
+      micros.push_back(seconds * 1e6);
+      total += seconds;
+      solved += !path.empty();
+      expanded += path::stats.expanded;
+    }
+    delete ps;
+  
+    std::sort(micros.begin(), micros.end());
+    std::cout << "{\"input\":" << json(input)
+              << ",\"alg\":" << json(alg)
+              << ",\"vertices\":" << graph.size()
+              << ",\"arcs\":" << graph.edges()
+              << ",\"queries\":" << pairs.size()
+              << ",\"seed\":" << seed
+              << ",\"solved\":" << solved
+              << ",\"preprocess_s\":" << preprocess
+              << ",\"median_us\":" << percentile(micros, 0.5)
+              << ",\"p99_us\":" << percentile(micros, 0.99)
+              << ",\"mean_us\":" << total * 1e6 / pairs.size()
+              << ",\"max_us\":" << micros.back()
+              << ",\"throughput_qps\":" << (total > 0 ? pairs.size() / total : 0)
+              << ",\"mean_expanded\":" << double(expanded) / pairs.size()
+              << "}\n";
+    std::cout.flush();
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include "pbfs.hpp"
+#include "barrier.hpp"
+#include "tracing.hpp"
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+typedef std::vector<std::atomic<uint64_t>> Bitmap;
+
+const std::memory_order relaxed = std::memory_order_relaxed;
+
+bool inline test(const Bitmap &bits, const size_t &u) {
+  return (bits[u >> 6].load(relaxed) >> (u & 63)) & 1;
+}
+
+// returns true if this call is the one that set the bit
+bool inline set(Bitmap &bits, const size_t &u) {
+  uint64_t mask = uint64_t(1) << (u & 63);
+  return !(bits[u >> 6].fetch_or(mask, relaxed) & mask);
+}
+
+void inline reset(Bitmap &bits, const size_t &u) {
+  bits[u >> 6].fetch_and(~(uint64_t(1) << (u & 63)), relaxed);
+}
+
+}
+
+path::PBFS::PBFS(const Graph &graph, const unsigned &threads) : PathSearch(graph), threads(std::max(1u, threads)) {}
+
+void path::PBFS::find(const size_t &s, const size_t &g, Path &path) {
+  static const size_t npos = -1;
+  const size_t n = G.size(), words = (n+63) / 64;
+  
+  std::vector<std::atomic<size_t>> parent(n);
+  for (auto &p : parent) p.store(npos, relaxed);
+  Bitmap visited(words), front(words), next(words);
+  
+  std::vector<size_t> frontier{s};
+  std::vector<std::vector<size_t>> local(threads);
+  std::vector<size_t> scout(threads);
+  set(visited, s);
+  set(front, s);
+  
+  size_t unexplored = G.edges() - G.adj(s).size(), depth = 0;
+  bool bottom_up = false, done = s == g;
+  Barrier barrier(threads);
+  
+  auto top_down_step = [&](const unsigned &t) {
+    size_t lo = frontier.size()*t / threads, hi = frontier.size()*(t+1) / threads;
+    for (size_t i = lo; i < hi; ++i) {
+      const size_t u = frontier[i];
+      for (const size_t v : G.adj(u)) {
+        if (test(visited, v)) continue;
+        if (set(next, v)) {
+          local[t].push_back(v);
+          scout[t] += G.adj(v).size();
+        }
+        size_t old = parent[v].load(relaxed);
+        while (u < old && !parent[v].compare_exchange_weak(old, u, relaxed));
+      }
+    }
+  };
+  
+  auto bottom_up_step = [&](const unsigned &t) {
+    size_t lo = words*t / threads * 64, hi = std::min(n, words*(t+1) / threads * 64);
+    for (size_t v = lo; v < hi; ++v) {
+      if (test(visited, v)) continue;
+      // neighbours are sorted, so the first hit is the smallest parent
+      for (const size_t u : G.adj(v)) {
+        if (!test(front, u)) continue;
+        parent[v].store(u, relaxed);
+        set(next, v);
+        local[t].push_back(v);
+        scout[t] += G.adj(v).size();
+        break;
+      }
+    }
+  };
+  
+  // run by one thread between two barriers
+  auto advance = [&]() {
+    for (const size_t &u : frontier) reset(front, u);
+    front.swap(next);
+    
+    size_t prev_size = frontier.size(), edges = 0;
+    frontier.clear();
+    for (unsigned t = 0; t < threads; ++t) {
+      frontier.insert(frontier.end(), local[t].begin(), local[t].end());
+      local[t].clear();
+      edges += scout[t];
+      scout[t] = 0;
+    }
+    for (const size_t &v : frontier) set(visited, v);
+    unexplored -= edges;
+    
+    ++depth;
+    PATH_TRACE(tracer.level(depth, bottom_up, frontier.size()));
+    
+    if (frontier.empty() || test(visited, g)) done = true;
+    else if (!bottom_up && edges > unexplored / alpha) bottom_up = true;
+    else if (bottom_up && frontier.size() < prev_size && frontier.size() < n / beta) bottom_up = false;
+  };
+  
+  auto worker = [&](const unsigned &t) {
+    while (!done) {
+      if (bottom_up) bottom_up_step(t);
+      else           top_down_step(t);
+      barrier.wait();
+      if (t == 0) advance();
+      barrier.wait();
+    }
+  };
+  
+  std::vector<std::thread> team;
+  for (unsigned t = 1; t < threads; ++t)
+    team.emplace_back(worker, t);
+  worker(0);
+  for (auto &th : team) th.join();
+  
+  if (!test(visited, g)) return;
+  
+  for (size_t cur = g; cur != npos; cur = parent[cur].load(relaxed))
+    path.push_back(cur);
+  std::reverse(path.begin(), path.end());
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "path.hpp"
+#include <atomic>
+
+#ifndef pbfs_hpp
+#define pbfs_hpp
+
+namespace path {
+
+// level-synchronous parallel BFS that switches between top-down and
+// bottom-up steps depending on the frontier size (Beamer et al.)
+//
+// a vertex always takes the smallest-index neighbour of the previous level
+// as its parent, in both directions, so the result does not depend on
+// thread scheduling
+class PBFS : public PathSearch {
+private:
+  static const unsigned alpha = 14, beta = 24;
+  
+  unsigned threads;
+  
+public:
+  PBFS(const Graph &graph, const unsigned &threads);
+  
+  void find(const size_t &s, const size_t &g, Path &path) override;
+};
+
+}
+
+#endif /* pbfs_hpp */
@@ -0,0 +1,71 @@
+#include "perfect.hpp"
+
+const size_t path::PerfectHash::npos;
+const uint32_t path::PerfectHash::empty;
+const uint32_t path::PerfectHash::overflow;
+const uint32_t path::PerfectHash::tries;
+
+namespace {
+
+uint64_t inline mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+}
+
+// FNV-1a and a multiply-rotate hash over the same bytes, so a collision of one
+// does not carry over to the other
+path::PerfectHash::Hash path::PerfectHash::hash(const char *p, const size_t &len) {
+  uint64_t a = 0xcbf29ce484222325ull, b = len;
+  for (size_t i = 0; i < len; ++i) {
+    a ^= (unsigned char)p[i];
+    a *= 0x100000001b3ull;
+    b = (b ^ (unsigned char)p[i]) * 0x9e3779b97f4a7c15ull;
+    b = b << 27 | b >> 37;
+  }
+  return {mix(a), mix(b)};
+}
+
+uint64_t path::PerfectHash::bucket(const Hash &h) {
+  return h.a;
+}
+
+uint64_t path::PerfectHash::base(const Hash &h) {
+  return h.b;
+}
+
+uint64_t path::PerfectHash::step(const Hash &h) {
+  return mix(h.a ^ (h.b >> 1)) | 1;
+}
+
+size_t path::PerfectHash::slot(const Hash &h, const uint32_t &d) const {
+  const size_t mask = slots.size() - 1;
+  return (base(h) + d * step(h)) & mask;
+}
+
+bool path::PerfectHash::place(const std::vector<Hash> &keys, const uint32_t &d, std::vector<size_t> &pos) const {
+  pos.clear();
+  for (const Hash &h : keys) {
+    size_t p = slot(h, d);
+    if (slots[p] != empty || std::find(pos.begin(), pos.end(), p) != pos.end()) return false;
+    pos.push_back(p);
+  }
+  return true;
+}
+
+size_t path::PerfectHash::find(const char *p, const size_t &len) const {
+  if (slots.empty()) return npos;
+  Hash h = hash(p, len);
+  uint32_t d = seeds[bucket(h) % seeds.size()];
+  if (d == overflow) {
+    auto it = std::lower_bound(spilled.begin(), spilled.end(), std::make_pair(h, uint32_t(0)));
+    return it != spilled.end() && !(h < it->first) ? it->second : npos;
+  }
+  uint32_t i = slots[slot(h, d)];
+  return i == empty ? npos : i;
+}
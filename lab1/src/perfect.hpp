@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#ifndef perfect_hash_hpp
+#define perfect_hash_hpp
+
+namespace path {
+
+// perfect hash over a fixed set of n distinct strings, "hash and displace"
+// (Belazzougui et al.): keys are split into about n/3 buckets by one hash,
+// then each bucket, largest first, picks the smallest displacement d that
+// moves all of its keys to free slots. The table is a power of two m with at
+// least n/4 spare slots, base and step come from hashes that are independent
+// of the bucket, and step is odd, so the slots base + d*step of one key for
+// d < m visit every slot once
+//
+// a bucket that finds no displacement within a bound is kept in a small
+// overflow list searched by fingerprint, the build never starts over
+//
+// lookup costs one string hash and two table reads, the index it returns is
+// only a candidate for strings outside the set, compare before trusting it
+//
+// it is not a minimal perfect hash: the indices are 0..n-1, but the slot
+// table holds 1.25n to 2.5n of them and a failed bucket goes to the overflow
+// list. The spare slots make the displacement search short, so building
+// millions of keys takes seconds, paid for with up to 10n bytes of table
+// instead of the 4n of a minimal layout
+class PerfectHash {
+private:
+  // two independent hashes of the bytes, the bucket, base and step are
+  // derived from them and together they fingerprint the key
+  struct Hash {
+    uint64_t a, b;
+    
+    bool operator<(const Hash &other) const { return a < other.a || (a == other.a && b < other.b); }
+  };
+  
+  static const uint32_t tries = 1u << 16;
+  static const uint32_t empty = -1;         // a slot without key
+  static const uint32_t overflow = tries;   // a seed no displacement search reaches
+  
+  std::vector<uint32_t> seeds;
+  std::vector<uint32_t> slots;
+  std::vector<std::pair<Hash, uint32_t>> spilled;  // sorted by hash
+  
+  static Hash hash(const char *p, const size_t &len);
+  
+  static uint64_t bucket(const Hash &h);
+  
+  static uint64_t base(const Hash &h);
+  
+  static uint64_t step(const Hash &h);
+  
+  size_t slot(const Hash &h, const uint32_t &d) const;
+  
+  // slots of the keys in one bucket under displacement d, false on a collision
+  bool place(const std::vector<Hash> &keys, const uint32_t &d, std::vector<size_t> &pos) const;
+  
+public:
+  static const size_t npos = -1;
+  
+  // `key(i)` returns the i-th string as a (pointer, length) pair, the keys
+  // must be distinct
+  template <typename Keys>
+  void build(const size_t &n, const Keys &key);
+  
+  size_t size() const { return slots.size(); }
+  
+  // keys that could not be placed and sit in the overflow list
+  size_t spills() const { return spilled.size(); }
+  
+  // index of the key equal to [p, p+len) if there is one, npos if there is
+  // certainly none
+  size_t find(const char *p, const size_t &len) const;
+};
+
+}
+
+template <typename Keys>
+void path::PerfectHash::build(const size_t &n, const Keys &key) {
+  const size_t nbuckets = n / 3 + 1;
+  size_t m = 1;
+  while (m < n + n / 4 + 1) m <<= 1;
+  // displacements from m on repeat the ones below it
+  const uint32_t limit = std::min<size_t>(tries, m);
+  
+  // keys grouped by bucket with a counting sort
+  std::vector<Hash> hashes(n);
+  std::vector<uint32_t> start(nbuckets + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    std::pair<const char *, size_t> k = key(i);
+    hashes[i] = hash(k.first, k.second);
+    ++start[bucket(hashes[i]) % nbuckets + 1];
+  }
+  for (size_t b = 0; b < nbuckets; ++b) start[b+1] += start[b];
+  std::vector<uint32_t> members(n);
+  {
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < n; ++i) members[fill[bucket(hashes[i]) % nbuckets]++] = i;
+  }
+  
+  // buckets from the largest down, also a counting sort
+  size_t largest = 0;
+  for (size_t b = 0; b < nbuckets; ++b) largest = std::max<size_t>(largest, start[b+1] - start[b]);
+  std::vector<uint32_t> order;
+  order.reserve(nbuckets);
+  {
+    std::vector<std::vector<uint32_t>> bysize(largest + 1);
+    for (size_t b = 0; b < nbuckets; ++b) bysize[start[b+1] - start[b]].push_back(b);
+    for (size_t s = largest; s > 0; --s) order.insert(order.end(), bysize[s].begin(), bysize[s].end());
+  }
+  
+  seeds.assign(nbuckets, 0);
+  slots.assign(m, empty);
+  spilled.clear();
+  std::vector<Hash> keys;
+  std::vector<size_t> pos;
+  
+  for (const uint32_t &b : order) {
+    keys.clear();
+    for (uint32_t j = start[b]; j < start[b+1]; ++j) keys.push_back(hashes[members[j]]);
+    
+    uint32_t d = 0;
+    while (d < limit && !place(keys, d, pos)) ++d;
+    if (d == limit) {
+      seeds[b] = overflow;
+      for (uint32_t j = start[b]; j < start[b+1]; ++j) spilled.push_back({hashes[members[j]], members[j]});
+      continue;
+    }
+    seeds[b] = d;
+    for (size_t j = 0; j < pos.size(); ++j) slots[pos[j]] = members[start[b] + j];
+  }
+  std::sort(spilled.begin(), spilled.end());
+}
+
+#endif /* perfect_hash_hpp */
@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#ifndef scratch_hpp
+#define scratch_hpp
+
+namespace path {
+
+// per-vertex array that forgets all of its values in O(1)
+//
+// every entry carries the generation it was written in, reset() starts a new
+// generation so stale entries read as the fallback value, a query then costs
+// time proportional to the vertices it touches instead of the graph size
+template <typename T>
+class StampedArray {
+private:
+  std::vector<T> values;
+  std::vector<uint32_t> stamps;
+  uint32_t epoch;
+  T fallback;
+  
+public:
+  StampedArray() : epoch(0), fallback() {}
+  
+  void reset(const size_t &n, const T &init);
+  
+  bool contains(const size_t &u) const { return stamps[u] == epoch; }
+  
+  const T &operator[](const size_t &u) const { return contains(u) ? values[u] : fallback; }
+  
+  void set(const size_t &u, const T &value) {
+    stamps[u] = epoch;
+    values[u] = value;
+  }
+};
+
+// vertex set with the same O(1) clear
+class StampedSet {
+private:
+  std::vector<uint32_t> stamps;
+  uint32_t epoch;
+  
+public:
+  StampedSet() : epoch(0) {}
+  
+  void reset(const size_t &n);
+  
+  bool contains(const size_t &u) const { return stamps[u] == epoch; }
+  
+  void insert(const size_t &u) { stamps[u] = epoch; }
+  
+  void erase(const size_t &u) { stamps[u] = 0; }
+};
+
+}
+
+template <typename T>
+void path::StampedArray<T>::reset(const size_t &n, const T &init) {
+  fallback = init;
+  if (stamps.size() != n) {
+    values.resize(n);
+    stamps.assign(n, 0);
+  }
+  // on wrap-around the stamps must be wiped once, 0 is never a live epoch
+  if (++epoch == 0) {
+    stamps.assign(n, 0);
+    epoch = 1;
+  }
+}
+
+void inline path::StampedSet::reset(const size_t &n) {
+  if (stamps.size() != n) stamps.assign(n, 0);
+  if (++epoch == 0) {
+    stamps.assign(n, 0);
+    epoch = 1;
+  }
+}
+
+#endif /* scratch_hpp */
@@ -0,0 +1,146 @@
+#include "sssp.hpp"
+#include "barrier.hpp"
+#include <atomic>
+#include <thread>
+#include <map>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+const std::memory_order relaxed = std::memory_order_relaxed;
+
+double inline cost(const path::Graph &G, const size_t &u, const size_t &i) {
+  return G.weighted() ? G.costs(u).begin()[i] : G.dist(u, G.adj(u).begin()[i]);
+}
+
+// lower dist[v] to d, returns true if this call changed it
+bool inline lower(std::atomic<double> &dist, const double &d) {
+  double old = dist.load(relaxed);
+  while (d < old) {
+    if (dist.compare_exchange_weak(old, d, relaxed)) return true;
+  }
+  return false;
+}
+
+}
+
+path::DeltaStepping::DeltaStepping(const Graph &graph, const unsigned &threads, const double &delta) : G(graph), threads(std::max(1u, threads)), delta(delta) {}
+
+double path::DeltaStepping::suggest(const Graph &graph) {
+  double sum = 0;
+  for (size_t u = 0; u < graph.size(); ++u) {
+    for (size_t i = 0; i < graph.adj(u).size(); ++i)
+      sum += cost(graph, u, i);
+  }
+  return graph.edges() && sum > 0 ? sum / graph.edges() : 1;
+}
+
+void path::DeltaStepping::run(const size_t &s, std::vector<double> &dist) {
+  static const double inf = std::numeric_limits<double>::infinity();
+  const size_t n = G.size();
+  
+  std::vector<std::atomic<double>> d(n);
+  for (auto &x : d) x.store(inf, relaxed);
+  d[s].store(0, relaxed);
+  
+  // buckets keep stale entries, a vertex only counts in the bucket of its
+  // current distance; the map skips the empty ranges of a small delta
+  std::map<uint64_t, std::vector<uint32_t>> buckets;
+  std::vector<uint32_t> frontier{uint32_t(s)}, settled;
+  std::vector<std::vector<uint32_t>> local(threads);
+  
+  // round[v] and phase[v] stamp membership in the frontier and in settled
+  std::vector<uint64_t> round(n, 0), phase(n, 0);
+  uint64_t rounds = 1, phases = 1, current = 0;
+  round[s] = rounds;
+  bool heavy = false, done = false;
+  Barrier barrier(threads);
+  
+  auto bucket = [&](const size_t &v) {
+    double b = d[v].load(relaxed) / delta;
+    return b < 1.8e19 ? uint64_t(b) : uint64_t(-1);
+  };
+  
+  auto step = [&](const unsigned &t) {
+    size_t lo = frontier.size()*t / threads, hi = frontier.size()*(t+1) / threads;
+    for (size_t k = lo; k < hi; ++k) {
+      const size_t u = frontier[k];
+      const double du = d[u].load(relaxed);
+      Span<uint32_t> adj = G.adj(u);
+      for (size_t i = 0; i < adj.size(); ++i) {
+        double w = cost(G, u, i);
+        if ((w > delta) != heavy) continue;
+        if (lower(d[adj.begin()[i]], du + w)) local[t].push_back(adj.begin()[i]);
+      }
+    }
+  };
+  
+  // run by one thread between two barriers
+  auto advance = [&]() {
+    if (!heavy) {
+      for (const uint32_t &u : frontier) {
+        if (phase[u] != phases) settled.push_back(u);
+        phase[u] = phases;
+      }
+    }
+    
+    // light arcs can refill the current bucket, those vertices go again
+    ++rounds;
+    frontier.clear();
+    for (unsigned t = 0; t < threads; ++t) {
+      for (const uint32_t &v : local[t]) {
+        uint64_t b = bucket(v);
+        if (b == current && !heavy) {
+          if (round[v] != rounds) frontier.push_back(v);
+          round[v] = rounds;
+        }
+        else {
+          buckets[b].push_back(v);
+        }
+      }
+      local[t].clear();
+    }
+    if (!frontier.empty()) return;
+    
+    if (!heavy) {
+      heavy = true;
+      frontier.swap(settled);
+      return;
+    }
+    
+    // the current bucket is final, move on to the lowest live one
+    heavy = false;
+    ++phases;
+    settled.clear();
+    while (frontier.empty() && !buckets.empty()) {
+      auto first = buckets.begin();
+      current = first->first;
+      for (const uint32_t &v : first->second) {
+        if (bucket(v) != current || round[v] == rounds) continue;
+        round[v] = rounds;
+        frontier.push_back(v);
+      }
+      buckets.erase(first);
+    }
+    if (frontier.empty()) done = true;
+  };
+  
+  auto worker = [&](const unsigned &t) {
+    while (!done) {
+      step(t);
+      barrier.wait();
+      if (t == 0) advance();
+      barrier.wait();
+    }
+  };
+  
+  std::vector<std::thread> team;
+  for (unsigned t = 1; t < threads; ++t)
+    team.emplace_back(worker, t);
+  worker(0);
+  for (auto &th : team) th.join();
+  
+  dist.resize(n);
+  for (size_t u = 0; u < n; ++u) dist[u] = d[u].load(relaxed);
+}
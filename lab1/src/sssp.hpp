@@ -0,0 +1,34 @@
+#pragma once
+#include "path.hpp"
+
+#ifndef sssp_hpp
+#define sssp_hpp
+
+namespace path {
+
+// parallel one-to-all shortest paths by delta-stepping (Meyer and Sanders)
+//
+// vertices are bucketed by tentative distance in steps of delta, the lowest
+// bucket is emptied by relaxing its light arcs (cost <= delta) in parallel
+// rounds until nothing lands in it again, then the heavy arcs of everything
+// it settled are relaxed once. Arc costs are the edge weights of the input,
+// or the straight-line distance if it gave none
+class DeltaStepping {
+private:
+  const Graph &G;
+  unsigned threads;
+  double delta;
+  
+public:
+  DeltaStepping(const Graph &graph, const unsigned &threads, const double &delta);
+  
+  // mean arc cost, a reasonable delta when nothing better is known
+  static double suggest(const Graph &graph);
+  
+  // dist[u] becomes the cost of the cheapest path from s, infinity if none
+  void run(const size_t &s, std::vector<double> &dist);
+};
+
+}
+
+#endif /* sssp_hpp */
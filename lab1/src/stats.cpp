@@ -0,0 +1,11 @@
+#include "stats.hpp"
+#include <sys/resource.h>
+
+thread_local path::Stats path::stats;
+
+size_t path::peak_memory() {
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  // linux reports kilobytes
+  return usage.ru_maxrss;
+}
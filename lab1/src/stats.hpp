@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+
+#ifndef stats_hpp
+#define stats_hpp
+
+namespace path {
+
+// what one query cost, the searches count into the copy of the calling
+// thread so the hot loops pay a plain increment and no synchronization
+struct Stats {
+  uint64_t expanded;    // vertices whose neighbours were generated
+  uint64_t relaxed;     // arcs looked at while expanding
+  uint64_t peak_open;   // largest open list, queue, frontier or recursion depth
+  uint64_t rounds;      // iterative deepening rounds
+  uint64_t reexpanded;  // expansions of a vertex expanded before, iterative deepening built to count them only
+  double seconds;       // search wall time
+  
+  Stats() { clear(); }
+  
+  void clear() {
+    expanded = relaxed = peak_open = rounds = reexpanded = 0;
+    seconds = 0;
+  }
+  
+  void open(const size_t &size) {
+    if (size > peak_open) peak_open = size;
+  }
+};
+
+extern thread_local Stats stats;
+
+// wall clock in seconds since construction or the previous lap
+class Stopwatch {
+private:
+  std::chrono::steady_clock::time_point last;
+  
+public:
+  Stopwatch() : last(std::chrono::steady_clock::now()) {}
+  
+  double lap() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(now - last).count();
+    last = now;
+    return s;
+  }
+};
+
+// peak resident set size of the process in kilobytes
+size_t peak_memory();
+
+}
+
+#endif /* stats_hpp */
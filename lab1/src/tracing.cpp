@@ -0,0 +1,96 @@
+#include "tracing.hpp"
+#include <iomanip>
+
+path::Tracer path::tracer;
+
+path::Tracer::Tracer() : mode(off), out(nullptr) {}
+
+bool path::Tracer::open(const Mode &mode, const std::string &filename) {
+  this->mode = mode;
+  if (mode == off) {
+    out.rdbuf(nullptr);
+    return true;
+  }
+  if (mode == json && filename != "-") {
+    file.open(filename);
+    if (!file) return false;
+    out.rdbuf(file.rdbuf());
+  }
+  else {
+    out.rdbuf(std::cout.rdbuf());
+  }
+  if (mode == text) out << std::fixed << std::setprecision(2);
+  else              out << std::setprecision(10);
+  return true;
+}
+
+void path::Tracer::label(const Graph &G, const size_t &u) {
+  out << '"';
+  for (const char &c : G.label(u)) {
+    if (c == '"' || c == '\\') out << '\\';
+    out << c;
+  }
+  out << '"';
+}
+
+void path::Tracer::query(const Graph &G, const size_t &s, const size_t &g) {
+  if (mode != json) return;
+  out << "{\"ev\":\"query\",\"s\":";
+  label(G, s);
+  out << ",\"g\":";
+  label(G, g);
+  out << "}\n";
+}
+
+void path::Tracer::expand(const Graph &G, const size_t &u, const char *prefix) {
+  if (mode == text) {
+    out << prefix << G.label(u) << "\n";
+    return;
+  }
+  out << "{\"ev\":\"expand\",\"v\":";
+  label(G, u);
+  out << "}\n";
+}
+
+void path::Tracer::relax(const Graph &G, const size_t &u, const size_t &v, const double &g, const double &h) {
+  if (mode == text) {
+    out << G.label(u) << " -> " << G.label(v) << " ; g=" << g << " h=" << h << " = " << g+h << "\n";
+    return;
+  }
+  out << "{\"ev\":\"relax\",\"u\":";
+  label(G, u);
+  out << ",\"v\":";
+  label(G, v);
+  out << ",\"g\":" << g << ",\"h\":" << h << "}\n";
+}
+
+void path::Tracer::hit(const Graph &G, const size_t &u, const int &depth) {
+  if (mode == text) {
+    out << "hit depth=" << depth << ": " << G.label(u) << "\n";
+    return;
+  }
+  out << "{\"ev\":\"hit\",\"v\":";
+  label(G, u);
+  out << ",\"depth\":" << depth << "}\n";
+}
+
+void path::Tracer::hit(const Graph &G, const size_t &u, const double &f) {
+  if (mode == text) {
+    out << "hit f=" << f << ": " << G.label(u) << "\n";
+    return;
+  }
+  out << "{\"ev\":\"hit\",\"v\":";
+  label(G, u);
+  out << ",\"f\":" << f << "}\n";
+}
+
+void path::Tracer::bound(const double &f) {
+  if (mode == text) out << "threshold=" << f << "\n";
+  else              out << "{\"ev\":\"bound\",\"f\":" << f << "}\n";
+}
+
+void path::Tracer::level(const size_t &depth, const bool &bottom_up, const size_t &frontier) {
+  const char *dir = bottom_up ? "bottom-up" : "top-down";
+  if (mode == text) out << "depth=" << depth << " " << dir << " frontier=" << frontier << "\n";
+  else              out << "{\"ev\":\"level\",\"depth\":" << depth << ",\"dir\":\"" << dir << "\",\"frontier\":" << frontier << "}\n";
+}
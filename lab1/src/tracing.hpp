@@ -0,0 +1,73 @@
+#pragma once
+#include "path.hpp"
+#include <iostream>
+#include <fstream>
+
+#ifndef tracing_hpp
+#define tracing_hpp
+
+// every trace statement goes through PATH_TRACE, it costs one predictable
+// branch when tracing is off and compiles to nothing with PATH_NO_TRACE
+#ifdef PATH_NO_TRACE
+#define PATH_TRACE(stmt) do {} while (0)
+#else
+#define PATH_TRACE(stmt) do { if (__builtin_expect(path::tracer.enabled(), 0)) { stmt; } } while (0)
+#endif
+
+namespace path {
+
+// search events, written either as the human readable verbose trace of the
+// lab or as one JSON object per line for profiling
+class Tracer {
+public:
+  enum Mode { off, text, json };
+  
+private:
+  Mode mode;
+  std::ofstream file;
+  std::ostream out;
+  
+  void label(const Graph &G, const size_t &u);
+  
+public:
+  Tracer();
+  
+  // `filename` is only used in json mode, `-` is standard output
+  bool open(const Mode &mode, const std::string &filename = "-");
+  
+  bool enabled() const { return mode != off; }
+  
+  void query(const Graph &G, const size_t &s, const size_t &g);
+  
+  // `prefix` starts the verbose line, "Expanding: " or "Expand: "
+  void expand(const Graph &G, const size_t &u, const char *prefix);
+  
+  // A* expansion, the verbose trace prints the whole path to u
+  template <typename Parents>
+  void expand(const Graph &G, const Parents &prev, const size_t &u) {
+    if (mode == json) {
+      expand(G, u, nullptr);
+      return;
+    }
+    Path path;
+    trace(prev, u, path);
+    out << "adding " << to_string(path, G) << "\n";
+  }
+  
+  void relax(const Graph &G, const size_t &u, const size_t &v, const double &g, const double &h);
+  
+  // u was cut off by the depth or f bound of an iterative deepening round
+  void hit(const Graph &G, const size_t &u, const int &depth);
+  
+  void hit(const Graph &G, const size_t &u, const double &f);
+  
+  void bound(const double &f);
+  
+  void level(const size_t &depth, const bool &bottom_up, const size_t &frontier);
+};
+
+extern Tracer tracer;
+
+}
+
+#endif /* tracing_hpp */
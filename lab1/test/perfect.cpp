@@ -0,0 +1,45 @@
+#include "../src/perfect.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+// builds the hash over n labels "v0".."v<n-1>" like the ones of graphgen and
+// checks that every label finds its own index and no other label does
+int main(int argc, char * argv[]) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+  std::string arena;
+  std::vector<size_t> offsets(n + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    arena += "v" + std::to_string(i);
+    offsets[i+1] = arena.size();
+  }
+  
+  path::PerfectHash hash;
+  hash.build(n, [&](const size_t &i) {
+    return std::make_pair(arena.data() + offsets[i], offsets[i+1] - offsets[i]);
+  });
+  
+  if (hash.size() < n + n / 4 || hash.size() > 4 * n + 2) {
+    std::cerr << "table of " << hash.size() << " slots for " << n << " keys\n";
+    return 1;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (hash.find(arena.data() + offsets[i], offsets[i+1] - offsets[i]) != i) {
+      std::cerr << "key " << i << " is not found\n";
+      return 1;
+    }
+  }
+  // outside the set the index is only a candidate, it must not be a key
+  // equal to the probe
+  for (size_t i = n; i < n + n / 10; ++i) {
+    std::string label = "v" + std::to_string(i);
+    size_t k = hash.find(label.data(), label.size());
+    if (k != path::PerfectHash::npos && arena.compare(offsets[k], offsets[k+1] - offsets[k], label) == 0) {
+      std::cerr << "label " << label << " is found\n";
+      return 1;
+    }
+  }
+  std::cout << n << " keys, " << hash.size() << " slots, " << hash.spills() << " in the overflow list\n";
+  return 0;
+}
@@ -0,0 +1,367 @@
+#include "cdcl.hpp"
+#include <algorithm>
+#include <utility>
+
+const std::size_t proposition::CDCL::none = -1;
+
+namespace {
+
+// i-th term of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ..., scales the restarts
+std::size_t luby(std::size_t i) {
+  std::size_t size = 1, seq = 0;
+  while (size < i+1) {
+    ++seq;
+    size = 2*size + 1;
+  }
+  while (size-1 != i) {
+    size = (size-1) >> 1;
+    --seq;
+    i = i % size;
+  }
+  return std::size_t(1) << seq;
+}
+
+}
+
+proposition::CDCL::CDCL(const Clauses &clauses, bool &ok) : symbols(clauses.symbols), head(0), inc(1) {
+  std::size_t n = symbols->size();
+  watches.resize(2*n);
+  value.assign(n, unbound);
+  level.assign(n, 0);
+  reason.assign(n, none);
+  activity.assign(n, 0);
+  slot.assign(n, none);
+  phase.assign(n, 0);
+  seen.assign(n, false);
+  used.assign(n, false);
+  // variables in name order, so equal activities decide like DPLL does
+  for (const int32_t &v : symbols->sorted()) push(v);
+  
+  ok = true;
+  const std::vector<Literal> &arena = clauses.data();
+  for (std::size_t i = 0; i < arena.size(); i += arena[i]+1) {
+    std::vector<Literal> lits(arena.begin()+i+1, arena.begin()+i+1+arena[i]);
+    for (const Literal &p : lits) used[p >> 1] = true;
+    if (!attach(lits)) {
+      ok = false;
+      return;
+    }
+  }
+  originals = db.size();
+  ok = propagate() == none;
+}
+
+// adds an input clause at level 0, false if it is already falsified
+bool proposition::CDCL::attach(std::vector<Literal> clause) {
+  // drop literals that are false at level 0, a satisfied clause is dropped whole
+  std::size_t k = 0;
+  for (const Literal &p : clause) {
+    if (val(p) == 1) return true;
+    if (val(p) == unbound) clause[k++] = p;
+  }
+  clause.resize(k);
+  
+  if (clause.empty()) return false;
+  if (clause.size() == 1) {
+    assign(clause[0], none);
+    return true;
+  }
+  db.push_back(std::move(clause));
+  watches[db.back()[0]^1].push_back(db.size()-1);
+  watches[db.back()[1]^1].push_back(db.size()-1);
+  return true;
+}
+
+void proposition::CDCL::assign(const Literal &p, const std::size_t &from) {
+  std::size_t v = p >> 1;
+  value[v] = !(p&1);
+  level[v] = depth();
+  reason[v] = from;
+  trail.push_back(p);
+}
+
+// unit propagation over the watches, returns the conflicting clause or none
+std::size_t proposition::CDCL::propagate() {
+  while (head < trail.size()) {
+    Literal p = trail[head++];
+    std::vector<std::size_t> &ws = watches[p];
+    Literal falsified = p^1;
+    
+    std::size_t i = 0, j = 0;
+    while (i < ws.size()) {
+      std::size_t c = ws[i++];
+      std::vector<Literal> &clause = db[c];
+      if (clause[0] == falsified) std::swap(clause[0], clause[1]);
+      
+      // the other watch already satisfies the clause
+      if (val(clause[0]) == 1) {
+        ws[j++] = c;
+        continue;
+      }
+      
+      // move the watch to a literal that is not false
+      bool moved = false;
+      for (std::size_t k = 2; k < clause.size(); ++k) {
+        if (val(clause[k]) != 0) {
+          std::swap(clause[1], clause[k]);
+          watches[clause[1]^1].push_back(c);
+          moved = true;
+          break;
+        }
+      }
+      if (moved) continue;
+      
+      ws[j++] = c;
+      if (val(clause[0]) == 0) {
+        while (i < ws.size()) ws[j++] = ws[i++];
+        ws.resize(j);
+        head = trail.size();
+        return c;
+      }
+      assign(clause[0], c);
+    }
+    ws.resize(j);
+  }
+  return none;
+}
+
+// resolves the conflict back to the first unique implication point of the
+// current level, learnt[0] is the asserting literal and learnt[1] the literal
+// of the level to jump back to
+void proposition::CDCL::analyze(std::size_t conflict, std::vector<Literal> &learnt, int &back) {
+  learnt.assign(1, 0);
+  std::size_t pending = 0, index = trail.size();
+  Literal p = -1;
+  do {
+    const std::vector<Literal> &clause = db[conflict];
+    for (std::size_t k = p == -1 ? 0 : 1; k < clause.size(); ++k) {
+      std::size_t v = clause[k] >> 1;
+      if (seen[v] || level[v] == 0) continue;
+      seen[v] = true;
+      bump(v);
+      if (level[v] == depth()) ++pending;
+      else learnt.push_back(clause[k]);
+    }
+    // the next literal of the trail that takes part in the conflict
+    while (!seen[trail[--index] >> 1]);
+    p = trail[index];
+    conflict = reason[p >> 1];
+    seen[p >> 1] = false;
+  } while (--pending > 0);
+  learnt[0] = p^1;
+  
+  // drop the literals whose reason only has literals already in the clause
+  std::size_t kept = 1;
+  for (std::size_t k = 1; k < learnt.size(); ++k) {
+    std::size_t from = reason[learnt[k] >> 1];
+    bool redundant = from != none;
+    for (std::size_t i = 1; redundant && i < db[from].size(); ++i) {
+      std::size_t v = db[from][i] >> 1;
+      redundant = seen[v] || level[v] == 0;
+    }
+    if (!redundant) std::swap(learnt[kept++], learnt[k]);
+  }
+  for (std::size_t k = kept; k < learnt.size(); ++k) seen[learnt[k] >> 1] = false;
+  learnt.resize(kept);
+  
+  back = 0;
+  for (std::size_t k = 1; k < learnt.size(); ++k) {
+    seen[learnt[k] >> 1] = false;
+    if (level[learnt[k] >> 1] > back) {
+      back = level[learnt[k] >> 1];
+      std::swap(learnt[1], learnt[k]);
+    }
+  }
+}
+
+void proposition::CDCL::backjump(const int &to) {
+  if (depth() <= to) return;
+  for (std::size_t i = trail.size(); i-- > limits[to];) {
+    std::size_t v = trail[i] >> 1;
+    phase[v] = value[v];
+    value[v] = unbound;
+    reason[v] = none;
+    if (slot[v] == none) push(v);
+  }
+  trail.resize(limits[to]);
+  limits.resize(to);
+  head = trail.size();
+}
+
+void proposition::CDCL::bump(const std::size_t &v) {
+  if ((activity[v] += inc) > 1e100) {
+    for (double &a : activity) a *= 1e-100;
+    inc *= 1e-100;
+  }
+  if (slot[v] != none) sift_up(slot[v]);
+}
+
+void proposition::CDCL::sift_up(std::size_t i) {
+  std::size_t v = heap[i];
+  while (i > 0 && activity[heap[(i-1)/2]] < activity[v]) {
+    heap[i] = heap[(i-1)/2];
+    slot[heap[i]] = i;
+    i = (i-1)/2;
+  }
+  heap[i] = v;
+  slot[v] = i;
+}
+
+void proposition::CDCL::sift_down(std::size_t i) {
+  std::size_t v = heap[i];
+  while (2*i+1 < heap.size()) {
+    std::size_t c = 2*i+1;
+    if (c+1 < heap.size() && activity[heap[c+1]] > activity[heap[c]]) ++c;
+    if (activity[heap[c]] <= activity[v]) break;
+    heap[i] = heap[c];
+    slot[heap[i]] = i;
+    i = c;
+  }
+  heap[i] = v;
+  slot[v] = i;
+}
+
+void proposition::CDCL::push(const std::size_t &v) {
+  heap.push_back(v);
+  sift_up(heap.size()-1);
+}
+
+std::size_t proposition::CDCL::pop() {
+  std::size_t v = heap[0];
+  slot[v] = none;
+  heap[0] = heap.back();
+  heap.pop_back();
+  if (!heap.empty()) sift_down(0);
+  return v;
+}
+
+// number of distinct decision levels in a clause, learnt clauses with few of
+// them are the ones worth keeping
+int proposition::CDCL::glue(const std::vector<Literal> &clause) const {
+  std::vector<int> levels;
+  for (const Literal &p : clause) levels.push_back(level[p >> 1]);
+  std::sort(levels.begin(), levels.end());
+  return std::unique(levels.begin(), levels.end()) - levels.begin();
+}
+
+// forgets the worse half of the learnt clauses, a clause that is the reason of
+// an assignment or has glue 2 is kept
+void proposition::CDCL::reduce() {
+  std::vector<std::size_t> order;
+  for (std::size_t c = originals; c < db.size(); ++c) order.push_back(c);
+  std::sort(order.begin(), order.end(), [this](const std::size_t &a, const std::size_t &b) -> bool {
+    return lbd[a-originals] > lbd[b-originals];
+  });
+  
+  std::vector<bool> drop(db.size(), false);
+  for (std::size_t k = 0; k < order.size()/2; ++k) {
+    std::size_t c = order[k];
+    std::size_t v = db[c][0] >> 1;
+    if (lbd[c-originals] <= 2) break;
+    if (value[v] != unbound && reason[v] == c) continue;
+    drop[c] = true;
+  }
+  
+  std::vector<std::size_t> moved(db.size(), none);
+  std::size_t j = originals;
+  for (std::size_t c = originals; c < db.size(); ++c) {
+    if (drop[c]) continue;
+    moved[c] = j;
+    if (j != c) {
+      lbd[j-originals] = lbd[c-originals];
+      db[j] = std::move(db[c]);
+    }
+    ++j;
+  }
+  verbose << "forget " << db.size() - j << " learnt clauses\n";
+  db.resize(j);
+  lbd.resize(j-originals);
+  
+  for (const Literal &p : trail) {
+    std::size_t &from = reason[p >> 1];
+    if (from != none && from >= originals) from = moved[from];
+  }
+  for (auto &ws : watches) {
+    std::size_t k = 0;
+    for (const std::size_t &c : ws) {
+      if (c < originals) ws[k++] = c;
+      else if (moved[c] != none) ws[k++] = moved[c];
+    }
+    ws.resize(k);
+  }
+}
+
+bool proposition::CDCL::search(Assignment &asgmt) {
+  std::vector<Literal> learnt;
+  std::size_t conflicts = 0, restarts = 0, budget = 100 * luby(0);
+  std::size_t total = 0, interval = 2000, forget = interval;
+  while (true) {
+    std::size_t conflict = propagate();
+    if (conflict != none) {
+      ++conflicts;
+      ++total;
+      if (depth() == 0) {
+        verbose << "conflict at level 0\n\n";
+        return false;
+      }
+      int back;
+      analyze(conflict, learnt, back);
+      // the trace is skipped entirely in the hot loop unless verbose is on
+      if (verbose.rdbuf()) {
+        verbose << "conflict, learn:";
+        for (const Literal &p : learnt) verbose << " " << name(p);
+        verbose << ", backjump to level " << back << "\n";
+      }
+      
+      backjump(back);
+      inc /= 0.95;
+      if (learnt.size() == 1) {
+        assign(learnt[0], none);
+        continue;
+      }
+      lbd.push_back(glue(learnt));
+      db.push_back(learnt);
+      watches[learnt[0]^1].push_back(db.size()-1);
+      watches[learnt[1]^1].push_back(db.size()-1);
+      assign(learnt[0], db.size()-1);
+      continue;
+    }
+    
+    if (total >= forget) {
+      reduce();
+      interval += 300;
+      forget = total + interval;
+    }
+    
+    if (conflicts >= budget) {
+      verbose << "restart\n";
+      backjump(0);
+      conflicts = 0;
+      budget = 100 * luby(++restarts);
+    }
+    
+    std::size_t v = none;
+    while (!heap.empty() && value[v = pop()] != unbound) v = none;
+    if (v == none) break;
+    
+    limits.push_back(trail.size());
+    assign(2*v + !phase[v], none);
+    if (verbose.rdbuf()) verbose << "decide: " << symbols->name(v) << "=" << (phase[v] ? "true" : "false") << " at level " << depth() << "\n";
+  }
+  
+  for (std::size_t v = 0; v < used.size(); ++v) {
+    if (used[v] && !symbols->hidden(v)) asgmt[symbols->name(v)] = value[v];
+  }
+  verbose << "\n";
+  return true;
+}
+
+bool proposition::CDCL::solve(const Clauses &clauses, Assignment &asgmt) {
+  bool ok;
+  CDCL solver(clauses, ok);
+  if (!ok) {
+    verbose << "contradiction at level 0\n\n";
+    return false;
+  }
+  return solver.search(asgmt);
+}
@@ -0,0 +1,84 @@
+#ifndef cdcl_hpp
+#define cdcl_hpp
+
+#pragma once
+#include "proposition.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace proposition {
+
+// conflict-driven clause learning
+//
+// every clause watches two of its literals and is only visited when one of
+// them becomes false, a conflict is analysed back to the first unique
+// implication point, the learnt clause is added and the search jumps back to
+// the second highest level in it. Decisions follow VSIDS activity with saved
+// phases, the search restarts on the Luby sequence and periodically forgets
+// the learnt clauses with the highest glue
+class CDCL {
+private:
+  static const std::size_t none;
+  
+  std::shared_ptr<const Symbols> symbols;
+  std::vector<bool> used;  // variables that are part of the answer
+  std::vector<std::vector<Literal>> db;  // input clauses, then the learnt ones
+  std::size_t originals;
+  std::vector<int> lbd;  // glue of every learnt clause
+  std::vector<std::vector<std::size_t>> watches;  // clauses watching a literal
+  
+  std::vector<int8_t> value;
+  std::vector<int> level;
+  std::vector<std::size_t> reason;
+  std::vector<Literal> trail;
+  std::vector<std::size_t> limits;  // trail size at every decision
+  std::size_t head;
+  
+  std::vector<double> activity;
+  std::vector<std::size_t> heap, slot;  // max-heap of variables by activity
+  double inc;
+  std::vector<int8_t> phase;
+  std::vector<bool> seen;
+  
+  CDCL(const Clauses &clauses, bool &ok);
+  
+  int8_t val(const Literal &p) const { return value[p>>1] == unbound ? unbound : value[p>>1] ^ (p&1); }
+  
+  int depth() const { return limits.size(); }
+  
+  std::string name(const Literal &p) const { return (p&1 ? "!" : "") + symbols->name(p>>1); }
+  
+  bool attach(std::vector<Literal> clause);
+  
+  void assign(const Literal &p, const std::size_t &from);
+  
+  std::size_t propagate();
+  
+  void analyze(std::size_t conflict, std::vector<Literal> &learnt, int &back);
+  
+  void backjump(const int &to);
+  
+  int glue(const std::vector<Literal> &clause) const;
+  
+  void reduce();
+  
+  void bump(const std::size_t &v);
+  
+  void sift_up(std::size_t i);
+  
+  void sift_down(std::size_t i);
+  
+  void push(const std::size_t &v);
+  
+  std::size_t pop();
+  
+  bool search(Assignment &asgmt);
+  
+public:
+  static bool solve(const Clauses &clauses, Assignment &asgmt);
+};
+
+}
+
+#endif /* cdcl_hpp */
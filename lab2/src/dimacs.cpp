@@ -0,0 +1,137 @@
+#include "dimacs.hpp"
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+bool space(const char &c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// reads an unsigned decimal, false if there is no digit
+bool number(const char *&p, const char *end, uint64_t &n) {
+  const char *first = p;
+  n = 0;
+  while (p < end && *p >= '0' && *p <= '9' && n <= INT32_MAX) n = 10*n + (*p++ - '0');
+  return p != first;
+}
+
+}
+
+bool proposition::Dimacs::parse(const char *p, const char *end, Clauses &clauses) {
+  unsigned line = 1;
+  uint64_t vars = 0, n = 0;
+  bool header = false, open = false, tautology = false;
+  
+  while (p < end) {
+    if (space(*p)) {
+      line += *p++ == '\n';
+      continue;
+    }
+    // comment lines, and the `%` that ends the SATLIB benchmark files
+    if (*p == 'c') {
+      while (p < end && *p != '\n') ++p;
+      continue;
+    }
+    if (*p == '%') break;
+  
+    if (*p == 'p') {
+      ++p;
+      while (p < end && (*p == ' ' || *p == '\t')) ++p;
+      bool cnf = end-p > 3 && p[0] == 'c' && p[1] == 'n' && p[2] == 'f' && space(p[3]);
+      p += 3*cnf;
+      while (p < end && (*p == ' ' || *p == '\t')) ++p;
+      if (header || !cnf || !number(p, end, vars) || vars > INT32_MAX) {
+        std::cerr << "Error: invalid problem line, expected one `p cnf <variables> <clauses>`. line " << line << "\n";
+        return false;
+      }
+      // the clause count is only a hint, it is not checked
+      while (p < end && *p != '\n') ++p;
+      clauses.symbols->reserve(vars);
+      for (uint64_t v = 1; v <= vars; ++v) clauses.symbols->intern(std::to_string(v));
+      header = true;
+      continue;
+    }
+    
+    bool neg = *p == '-';
+    p += neg;
+    if (!number(p, end, n) || (p < end && !space(*p))) {
+      std::cerr << "Error: invalid token. line " << line << "\n";
+      return false;
+    }
+    if (!header) {
+      std::cerr << "Error: clause before the `p cnf` line. line " << line << "\n";
+      return false;
+    }
+    if (n > vars) {
+      std::cerr << "Error: variable " << n << " is out of range 1.." << vars << ". line " << line << "\n";
+      return false;
+    }
+  
+    if (n == 0) {
+      if (!open) clauses.open();
+      if (tautology) clauses.pop();
+      open = tautology = false;
+      continue;
+    }
+    if (!open) clauses.open();
+    open = true;
+    Literal lit = 2*Literal(n-1) + neg;
+    // a clause with a literal and its negation is always true
+    tautology |= clauses.clashes(lit);
+    if (!tautology) clauses.push(lit);
+  }
+  
+  if (!header) {
+    std::cerr << "Error: missing `p cnf` line\n";
+    return false;
+  }
+  // the last clause may end with the file instead of a 0
+  if (open && tautology) clauses.pop();
+  return true;
+}
+
+bool proposition::Dimacs::load(const std::string &filename, Clauses &clauses) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Error: failed to open file `" + filename + "`\n";
+    return false;
+  }
+  
+  struct stat st;
+  void *addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (addr == MAP_FAILED) {
+    // an empty file has no `p cnf` line
+    return parse(nullptr, nullptr, clauses);
+  }
+  madvise(addr, st.st_size, MADV_SEQUENTIAL);
+  
+  const char *base = static_cast<const char *>(addr);
+  bool ok = parse(base, base + st.st_size, clauses);
+  munmap(addr, st.st_size);
+  return ok;
+}
+
+void proposition::Dimacs::save(std::ostream &os, const Clauses &clauses) {
+  const std::vector<Literal> &arena = clauses.data();
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < arena.size(); i += arena[i]+1) ++count;
+  
+  for (std::size_t v = 0; v < clauses.symbols->size(); ++v) {
+    os << "c " << v+1 << " " << clauses.symbols->name(v) << "\n";
+  }
+  os << "p cnf " << clauses.symbols->size() << " " << count << "\n";
+  for (std::size_t i = 0; i < arena.size(); i += arena[i]+1) {
+    for (std::size_t k = i+1; k <= i+arena[i]; ++k) {
+      os << (arena[k]&1 ? "-" : "") << (arena[k] >> 1) + 1 << " ";
+    }
+    os << "0\n";
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef dimacs_hpp
+#define dimacs_hpp
+
+#pragma once
+#include "proposition.hpp"
+#include <iostream>
+#include <string>
+
+namespace proposition {
+
+// DIMACS `p cnf` files, variable k is interned as the name "k"
+//
+// the input is mapped read-only and scanned in place, so a large instance is
+// never copied into a stream or split into token strings
+class Dimacs {
+private:
+  static bool parse(const char *p, const char *end, Clauses &clauses);
+  
+public:
+  static bool load(const std::string &filename, Clauses &clauses);
+  
+  // writes the clauses with a comment line for every variable name
+  static void save(std::ostream &os, const Clauses &clauses);
+};
+
+}
+
+#endif /* dimacs_hpp */
@@ -1,4 +1,6 @@
 #include "proposition.hpp"
+#include "cdcl.hpp"
+#include "dimacs.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -8,32 +10,50 @@
 #include <getopt.h>
 
 std::string mode, input;
+bool emit_dimacs = false, tseitin = false;
 
 bool arguments(int argc, char * argv[]) {
   static const option options[] = {
-    {"verbose", no_argument,       nullptr, 'v'},
-    {"mode",    required_argument, nullptr, 'm'},
-    {nullptr,   no_argument,       nullptr,  0}
+    {"verbose",     no_argument,       nullptr, 'v'},
+    {"mode",        required_argument, nullptr, 'm'},
+    {"emit-dimacs", no_argument,       nullptr, 'd'},
+    {"tseitin",     no_argument,       nullptr, 't'},
+    {nullptr,       no_argument,       nullptr,  0}
   };
   
   int c = 0, idx = 0;
-  while ((c = getopt_long(argc, argv, "vm:", options, &idx)) != -1) {
+  while ((c = getopt_long(argc, argv, "vm:dt", options, &idx)) != -1) {
     switch (c) {
       case 'v':
         proposition::verbose.rdbuf(std::cout.rdbuf());
         break;
       case 'm':
         mode = optarg;
-        if (mode != "cnf" && mode != "dpll" && mode != "solver") {
+        if (mode != "cnf" && mode != "dpll" && mode != "cdcl" && mode != "dimacs" && mode != "solver") {
           std::cerr << "Error: unknown algorithm `" << mode << "`\n";
           return false;
         }
         break;
+      case 'd':
+        emit_dimacs = true;
+        break;
+      case 't':
+        tseitin = true;
+        break;
       default:
         return false;
     }
   }
   
+  if (emit_dimacs && mode != "cnf") {
+    std::cerr << "Error: `--emit-dimacs` only applies to the `cnf` mode\n";
+    return false;
+  }
+  if (tseitin && mode != "cnf" && mode != "solver") {
+    std::cerr << "Error: `--tseitin` only applies to the `cnf` and `solver` modes\n";
+    return false;
+  }
+  
   if (mode.empty()) {
     std::cerr << "Error: missing arguments. Require running mode, use `-m` or `--mode to specify\n";
     return false;
@@ -62,12 +82,11 @@ bool convert_to_cnf(const std::string &filename, proposition::Clauses &clauses)
     ++line;
     bnf.erase(std::remove_if(bnf.begin(), bnf.end(), isspace), bnf.end());
     if (bnf.empty()) continue;
-    if (!proposition::CnfConverter::isvalid(bnf, 0, bnf.size())) {
+    bool ok = tseitin ? proposition::CnfConverter::tseitin(bnf, clauses) : proposition::CnfConverter::solve(bnf, clauses);
+    if (!ok) {
       std::cerr << "Error: input file is not parseable. line " << line << "\n";
       return false;
     }
-    proposition::CnfConverter::solve(bnf);
-    proposition::CnfConverter::extract_literals(bnf, clauses);
   }
   return true;
 }
@@ -82,7 +101,7 @@ bool load_cnf(const std::string &filename, proposition::Clauses &clauses) {
   unsigned line = 0;
   while (std::getline(in, cnf)) {
     ++line;
-    clauses.push_back({});
+    clauses.open();
     std::istringstream iss(cnf);
     bool neg = false;
     while (iss >> token) {
@@ -108,7 +127,7 @@ bool load_cnf(const std::string &filename, proposition::Clauses &clauses) {
             return false;
           }
         }
-        clauses.back()[token] = neg;
+        clauses.push(2*clauses.symbols->intern(token) + neg);
         neg = false;
       }
     }
@@ -124,13 +143,25 @@ int main(int argc, char * argv[]) {
   if (mode == "cnf" || mode == "solver") {
     if (!convert_to_cnf(input, clauses)) return 1;
     proposition::verbose << "----------------------------------------\n";
-    proposition::verbose << "step 6: remove sentences that includes an atom and its negation [all]\n";
-    std::cout << clauses << "\n";
+    if (tseitin) proposition::verbose << "step 2: all clauses, auxiliary variables start with @\n";
+    else proposition::verbose << "step 6: remove sentences that includes an atom and its negation [all]\n";
+    if (emit_dimacs) proposition::Dimacs::save(std::cout, clauses);
+    else std::cout << clauses << "\n";
   }
   if (mode == "dpll") {
     if (!load_cnf(input, clauses)) return 1;
     std::cout << clauses << "\n";
   }
+  if (mode == "cdcl" || mode == "dimacs") {
+    // industrial inputs are large, only echo the clauses when verbose
+    if (mode == "cdcl" && !load_cnf(input, clauses)) return 1;
+    if (mode == "dimacs" && !proposition::Dimacs::load(input, clauses)) return 1;
+    if (proposition::verbose.rdbuf()) proposition::verbose << clauses << "\n";
+    if (proposition::CDCL::solve(clauses, asgmt))
+      std::cout << asgmt;
+    else
+      std::cout << "NO VALID ASSIGNMENT\n";
+  }
   if (mode == "dpll" || mode == "solver") {
     if (proposition::DPLL::solve(clauses, asgmt))
       std::cout << asgmt;
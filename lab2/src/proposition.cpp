@@ -15,451 +15,693 @@ std::ostream& operator<<(std::ostream& os, const proposition::Assignment &asgmt)
   return os;
 }
 
-std::ostream& operator<<(std::ostream& os, const proposition::Clauses& clauses) {
-  for (auto &clause : clauses) {
-    for (auto &literal : clause) {
-      os << (literal.second ? "!" : "") << literal.first << " ";
+namespace {
+
+// the clauses from the arena index from on, one per line
+void print(std::ostream& os, const proposition::Clauses& clauses, const std::size_t &from) {
+  const std::vector<proposition::Literal> &arena = clauses.data();
+  for (std::size_t i = from; i < arena.size(); i += arena[i]+1) {
+    for (std::size_t k = i+1; k <= i+arena[i]; ++k) {
+      os << (arena[k]&1 ? "!" : "") << clauses.symbols->name(arena[k] >> 1) << " ";
     }
     os << "\n";
   }
+}
+
+}
+
+std::ostream& operator<<(std::ostream& os, const proposition::Clauses& clauses) {
+  print(os, clauses, 0);
   return os;
 }
 
-bool proposition::CnfConverter::isliteral(const std::string &bnf, std::size_t &i) {
-  if (i >= bnf.size()) return false;
-  if (!std::isalnum(bnf[i]) && bnf[i] != '_') return false;
-  while (++i < bnf.size() && (std::isalnum(bnf[i]) || bnf[i] == '_'));
-  return true;
+void proposition::Symbols::reserve(const std::size_t &n) {
+  names.reserve(n);
+  ids.reserve(n);
 }
 
-bool proposition::CnfConverter::isop(const std::string &bnf, std::size_t &i) {
-  if (i >= bnf.size()) return false;
-  if (bnf[i]=='&' || bnf[i]=='|') { ++i; return true; }
-  if (i+1<bnf.size() && bnf[i]=='=' && bnf[i+1]=='>') { i+=2; return true; }
-  if (i+2<bnf.size() && bnf[i]=='<' && bnf[i+1]=='=' && bnf[i+2]=='>') { i+=3; return true; }
-  return false;
+int32_t proposition::Symbols::intern(const std::string &name) {
+  auto it = ids.emplace(name, names.size());
+  if (it.second) {
+    names.push_back(name);
+    aux.push_back(false);
+  }
+  return it.first->second;
+}
+
+int32_t proposition::Symbols::fresh() {
+  int32_t v = intern("@" + std::to_string(++made));
+  aux[v] = true;
+  return v;
+}
+
+std::vector<int32_t> proposition::Symbols::sorted() const {
+  std::vector<int32_t> order(names.size());
+  for (std::size_t v = 0; v < order.size(); ++v) order[v] = v;
+  std::sort(order.begin(), order.end(), [this](const int32_t &a, const int32_t &b) -> bool {
+    return names[a] < names[b];
+  });
+  return order;
+}
+
+void proposition::Clauses::open() {
+  last = arena.size();
+  arena.push_back(0);
 }
 
-std::size_t proposition::CnfConverter::find_next_term(const std::string &bnf, std::size_t i) {
-  while (bnf[i] == '!') ++i;
-  if (bnf[i] == '(') {
-    int depth = 0;
-    while (++i < bnf.size()) {
-      if (bnf[i] == ')' && depth == 0) break;
-      if (bnf[i] == '(') ++depth;
-      if (bnf[i] == ')') --depth;
+// arena index of variable v in the last clause, 0 if it is not there. Short
+// clauses are scanned, longer ones index their variables in where
+std::size_t proposition::Clauses::find(const int32_t &v) const {
+  if (last >= arena.size()) return 0;
+  if (arena[last] <= scan) {
+    for (std::size_t k = last+1; k < arena.size(); ++k) {
+      if (arena[k] >> 1 == v) return k;
     }
-    if (i >= bnf.size()) return -1;
-    ++i;
+    return 0;
   }
-  else {
-    while (i < bnf.size() && (std::isalnum(bnf[i]) || bnf[i] == '_')) ++i;
-  }
-  return i;
+  std::size_t k = std::size_t(v) < where.size() ? where[v] : 0;
+  return k > last && k < arena.size() && arena[k] >> 1 == v ? k : 0;
 }
 
-void proposition::CnfConverter::group(std::string &bnf, const std::size_t &i=0) {
-  std::size_t idx[4] = {};
-  std::size_t j = i, k;
-  while (true) {
-    while (bnf[j] == '!') ++j;
-    if (bnf[j] == '(') group(bnf, j+1);
-    k = find_next_term(bnf, j);
-    if (k == bnf.size() || bnf[k] == ')') break;
-    std::size_t tmp;
-    if (bnf[k] == '&')      tmp = 0;
-    else if (bnf[k] == '|') tmp = 1;
-    else if (bnf[k] == '=') tmp = 2;
-    else if (bnf[k] == '<') tmp = 3;
-    else assert(false);
-    idx[tmp] = k;
-    j = k + (tmp ? tmp : 1);
+void proposition::Clauses::push(const Literal &p) {
+  std::size_t k = find(p >> 1);
+  if (k) {
+    arena[k] = p;
+    return;
+  }
+  arena.push_back(p);
+  if (++arena[last] <= scan) return;
+  for (k = arena[last] == scan+1 ? last+1 : arena.size()-1; k < arena.size(); ++k) {
+    std::size_t v = arena[k] >> 1;
+    if (v >= where.size()) where.resize(v+1, 0);
+    where[v] = k;
   }
-  
-  for (j = 3; j <= 3 && !idx[j]; --j);
-  if (j > 3) return;
-  
-  std::string left = bnf.substr(0, i);
-  std::string right = bnf.substr(k, bnf.size());
-  std::string term1 = bnf.substr(i, idx[j]-i);
-  idx[j] += j ? j : 1;
-  std::string term2 = bnf.substr(idx[j], k-idx[j]);
-  
-  group(term1, 0);
-  group(term2, 0);
-  
-  if (find_next_term(term1, 0) != term1.size())
-    term1 = "(" + term1 + ")";
-  if (find_next_term(term2, 0) != term2.size())
-    term2 = "(" + term2 + ")";
-  
-  static const std::string op[4] = {"&", "|", "=>", "<=>"};
-  bnf = left + term1 + op[j] + term2 + right;
 }
 
-void proposition::CnfConverter::elim_iff(std::string &bnf, const std::size_t &i=0) {
-  std::size_t tmp;
-  tmp = i;
-  while (bnf[tmp] == '!') ++tmp;
-  if (bnf[tmp] == '(') elim_iff(bnf, tmp+1);
-  std::size_t j = find_next_term(bnf, i);
-  
-  if (j >= bnf.size() || bnf[j] == ')') return;
-  
-  std::size_t x;
-  if (bnf[j] == '&' || bnf[j] == '|') x = 1;
-  else if (bnf[j] == '=') x = 2;
-  else if (bnf[j] == '<') x = 3;
-  else assert(false);
-  
-  tmp = j+x;
-  while (bnf[tmp] == '!') ++tmp;
-  if (bnf[tmp] == '(') elim_iff(bnf, tmp+1);
-  std::size_t k = find_next_term(bnf, j+x);
-  
-  if (bnf[j] != '<') return;
-  
-  std::string left = bnf.substr(0, i);
-  std::string right = bnf.substr(k, bnf.size()-k);
-  std::string term1 = bnf.substr(i, j-i);
-  std::string term2 = bnf.substr(j+x, k-j-x);
-  
-  bnf = left + "(" + term1 + "=>" + term2 + ")&(" + term2 + "=>" + term1 + ")" + right;
+bool proposition::Clauses::clashes(const Literal &p) const {
+  std::size_t k = find(p >> 1);
+  return k && arena[k] == (p^1);
 }
 
-void proposition::CnfConverter::elim_imply(std::string &bnf, const std::size_t &i=0) {
-  std::size_t tmp;
-  tmp = i;
-  while (bnf[tmp] == '!') ++tmp;
-  if (bnf[tmp] == '(') elim_imply(bnf, tmp+1);
-  std::size_t j = find_next_term(bnf, i);
-  
-  if (j >= bnf.size() || bnf[j] == ')') return;
-  
-  std::size_t x;
-  if (bnf[j] == '&' || bnf[j] == '|') x = 1;
-  else if (bnf[j] == '=') x = 2;
-  else if (bnf[j] == '<') x = 3;
-  else assert(false);
-  
-  tmp = j+x;
-  while (bnf[tmp] == '!') ++tmp;
-  if (bnf[tmp] == '(') elim_imply(bnf, tmp+1);
-  std::size_t k = find_next_term(bnf, j+x);
-  
-  if (bnf[j] != '=') return;
-  
-  std::string left = bnf.substr(0, i);
-  std::string right = bnf.substr(k, bnf.size()-k);
-  std::string term1 = bnf.substr(i, j-i);
-  std::string term2 = bnf.substr(j+x, k-j-x);
-  
-  bnf = left + "!" + term1 + "|" + term2 + right;
+void proposition::Clauses::pop() {
+  arena.resize(last);
+  last = -1;
+}
+
+int proposition::Formula::precedence(const Op &op) {
+  static const int prec[] = {0, 0, 4, 3, 2, 1};
+  return prec[op];
+}
+
+proposition::Formula::Id proposition::Formula::make(const Op &op, const Id &left, const Id &right) {
+  Node node = {op, left, right};
+  auto it = table.find(node);
+  if (it != table.end()) return it->second;
+  nodes.push_back(node);
+  table.emplace(node, Id(nodes.size()-1));
+  return nodes.size()-1;
 }
 
-void proposition::CnfConverter::reduce_negation(std::string &bnf) {
+namespace {
+
+bool isname(const char &c) {
+  return std::isalnum(c) || c == '_';
+}
+
+proposition::Formula::Op binary(const char &kind) {
+  using proposition::Formula;
+  return kind == '&' ? Formula::AND : kind == '|' ? Formula::OR : kind == '=' ? Formula::IMPLY : kind == '<' ? Formula::IFF : Formula::VAR;
+}
+
+}
+
+// one pass over the line, false on a character that starts no token
+bool proposition::Formula::tokenize(const std::string &bnf, std::vector<Token> &tokens) {
   std::size_t i = 0;
-  while ((i = bnf.find("!!", i)) != std::string::npos) {
-    std::size_t j = i;
-    while (bnf[j] == '!') ++j;
-    bnf.erase(i, j-i-((j-i)%2));
+  while (i < bnf.size()) {
+    char c = bnf[i];
+    if (std::isspace(c)) {
+      ++i;
+      continue;
+    }
+    if (isname(c)) {
+      std::size_t j = i;
+      while (j < bnf.size() && isname(bnf[j])) ++j;
+      tokens.push_back({'a', symbols->intern(bnf.substr(i, j-i))});
+      i = j;
+      continue;
+    }
+    if (c == '=' && bnf.compare(i, 2, "=>") == 0) i += 2;
+    else if (c == '<' && bnf.compare(i, 3, "<=>") == 0) i += 3;
+    else if (c == '!' || c == '(' || c == ')' || c == '&' || c == '|') ++i;
+    else return false;
+    tokens.push_back({c, 0});
   }
+  tokens.push_back({0, 0});
+  return true;
 }
 
-void proposition::CnfConverter::de_morgan(std::string &bnf) {
+// precedence climbing without recursion so deep parenthesis fit the stack.
+// Negations, open parenthesis and binary operators wait in ops, finished
+// operands in out. Operators of the same precedence group to the left
+proposition::Formula::Id proposition::Formula::parse(const std::string &bnf) {
+  std::vector<Token> tokens;
+  if (!tokenize(bnf, tokens)) return -1;
+  
+  std::vector<char> ops;
+  std::vector<Id> out;
+  // makes the binary operators on top of ops that bind at least as tight as prec
+  auto reduce = [&](const int &prec) {
+    while (!ops.empty() && ops.back() != '(' && precedence(binary(ops.back())) >= prec) {
+      Id right = out.back();
+      out.pop_back();
+      out.back() = make(binary(ops.back()), out.back(), right);
+      ops.pop_back();
+    }
+  };
+  // the negations in front of the operand just finished
+  auto negate = [&]() {
+    while (!ops.empty() && ops.back() == '!') {
+      out.back() = make(NOT, out.back());
+      ops.pop_back();
+    }
+  };
   std::size_t i = 0;
-  while ((i = bnf.find("!(", i)) != std::string::npos) {
-    std::size_t j = find_next_term(bnf, i+2);
-    std::size_t k = bnf[j]!=')' ? find_next_term(bnf, j+1) : j;
-    
-    std::string left = bnf.substr(0, i) + "(";
-    std::string right = bnf.substr(k, bnf.size()-k);
-    std::string term1 = bnf.substr(i+2, j-i-2);
-    std::string term2 = j!=k ? bnf.substr(j+1, k-j-1) : "";
-    std::string op = j!=k ? (bnf[j]=='&' ? "|" : "&") : "";
-    
-    if (term1[0] == '!') term1.erase(0, 1);
-    else term1 = "!" + term1;
-    if (term2.empty());
-    else if (term2[0] == '!') term2.erase(0, 1);
-    else term2 = "!" + term2;
-    
-    bnf = left + term1 + op + term2 + right;
+  while (true) {
+    while (tokens[i].kind == '!' || tokens[i].kind == '(') ops.push_back(tokens[i++].kind);
+    if (tokens[i].kind != 'a') return -1;
+    out.push_back(make(VAR, tokens[i++].var));
+    negate();
+    while (tokens[i].kind == ')') {
+      reduce(1);
+      if (ops.empty() || ops.back() != '(') return -1;
+      ops.pop_back();
+      ++i;
+      negate();
+    }
+    if (!tokens[i].kind) break;
+    Op op = binary(tokens[i].kind);
+    if (op == VAR) return -1;
+    reduce(precedence(op));
+    ops.push_back(tokens[i++].kind);
   }
+  reduce(1);
+  return ops.empty() ? out.back() : -1;
 }
 
-void proposition::CnfConverter::reduce_parenthesis(std::string &bnf) {
-  std::size_t i = 0, j = bnf.size();
-  while (bnf[i] == '(') {
-    j = find_next_term(bnf, i);
-    if (j == bnf.size()) {
-      bnf.erase(j-1, 1);
-      bnf.erase(i, 1);
+void proposition::Formula::postorder(const Id &n, std::vector<bool> &seen, std::vector<Id> &order) const {
+  seen.resize(nodes.size(), false);
+  // a node is pushed again with done set once its operands are pushed
+  std::vector<std::pair<Id, bool>> stack(1, std::make_pair(n, false));
+  while (!stack.empty()) {
+    Id k = stack.back().first;
+    bool done = stack.back().second;
+    stack.pop_back();
+    if (done) {
+      order.push_back(k);
+      continue;
     }
-    else break;
+    if (seen[k]) continue;
+    seen[k] = true;
+    stack.emplace_back(k, true);
+    if (nodes[k].op == VAR) continue;
+    if (nodes[k].op != NOT) stack.emplace_back(nodes[k].right, false);
+    stack.emplace_back(nodes[k].left, false);
+  }
+}
+
+void proposition::Formula::print(std::ostream &os, const Id &n, const bool &grouped) const {
+  static const char *symbol[] = {"", "!", "&", "|", "=>", "<=>"};
+  // either a piece of text or a node still to print
+  std::vector<std::pair<const char *, Id>> stack(1, std::make_pair(nullptr, n));
+  auto operand = [&](const Id &k, const bool &paren) {
+    if (paren) stack.emplace_back(")", -1);
+    stack.emplace_back(nullptr, k);
+    if (paren) stack.emplace_back("(", -1);
+  };
+  while (!stack.empty()) {
+    const char *text = stack.back().first;
+    Id k = stack.back().second;
+    stack.pop_back();
+    if (text) {
+      os << text;
+      continue;
+    }
+    const Node &node = nodes[k];
+    if (node.op == VAR) {
+      os << symbols->name(node.left);
+      continue;
+    }
+    const Node &left = nodes[node.left];
+    if (node.op == NOT) {
+      os << symbol[NOT];
+      operand(node.left, left.op > NOT);
+      continue;
+    }
+    const Node &right = nodes[node.right];
+    operand(node.right, right.op > NOT && (grouped || precedence(right.op) <= precedence(node.op)));
+    stack.emplace_back(symbol[node.op], -1);
+    operand(node.left, left.op > NOT && (grouped || precedence(left.op) < precedence(node.op)));
   }
-  while ((i = bnf.find("(", i)) != std::string::npos) {
-    j = find_next_term(bnf, i+1);
-    if (bnf[i]=='(' && bnf[j]==')') {
-      bnf.erase(j, 1);
-      bnf.erase(i, 1);
+}
+
+proposition::Formula::Id proposition::CnfConverter::rewrite(Formula &f, const Id &root, Id (*rule)(Formula &, const Formula::Node &)) {
+  std::vector<bool> seen;
+  std::vector<Id> order, memo(f.size(), -1);
+  f.postorder(root, seen, order);
+  for (const Id &n : order) {
+    Formula::Node node = f[n];
+    if (node.op != Formula::VAR) {
+      node.left = memo[node.left];
+      if (node.op != Formula::NOT) node.right = memo[node.right];
     }
-    else ++i;
+    memo[n] = rule(f, node);
   }
+  return memo[root];
 }
 
-void proposition::CnfConverter::distribution(std::string &bnf, const std::size_t &i=0) {
-  if (bnf[i] == '(') distribution(bnf, i+1);
-  std::size_t j = find_next_term(bnf, i);
-  
-  if (j >= bnf.size() || bnf[j] == ')') return;
-  
-  if (bnf[j+1] == '(') distribution(bnf, j+2);
-  std::size_t k = find_next_term(bnf, j+1);
-  
-  if (bnf[j] != '|') return;
-  
-  std::size_t j1 = bnf[i]=='(' ? find_next_term(bnf, i+1) : 0;
-  std::size_t j2 = bnf[j+1]=='(' ? find_next_term(bnf, j+2) : 0;
-  
-  if ((!j1 || bnf[j1]!='&') && (!j2 || bnf[j2]!='&')) return;
-  
-  std::string left = bnf.substr(0, i);
-  std::string right = bnf.substr(k, bnf.size()-k);
-  std::string term1 = (j1 && bnf[j1]=='&') ? bnf.substr(i+1, j1-i-1) : bnf.substr(i, j-i);
-  std::string term2 = (j1 && bnf[j1]=='&') ? bnf.substr(j1+1, j-j1-2) : "";
-  std::string term3 = (j2 && bnf[j2]=='&') ? bnf.substr(j+2, j2-j-2) : bnf.substr(j+1, k-j-1);
-  std::string term4 = (j2 && bnf[j2]=='&') ? bnf.substr(j2+1, k-j2-2) : "";
-  
-  std::string nt1 = "(" + term1 + "|" + term3 + ")";
-  std::string nt2 = "(" + term1 + "|" + term4 + ")";
-  std::string nt3 = "(" + term2 + "|" + term3 + ")";
-  std::string nt4 = "(" + term2 + "|" + term4 + ")";
-  
-  if ((j1 && bnf[j1]=='&') || (j2 && bnf[j2]=='&')) distribution(nt1, 1);
-  if (j2 && bnf[j2]=='&')                           distribution(nt2, 1);
-  if (j1 && bnf[j1]=='&')                           distribution(nt3, 1);
-  if (j1 && bnf[j1]=='&' && j2 && bnf[j2]=='&')     distribution(nt4, 1);
-  
-  if (j1 && bnf[j1]=='&' && j2 && bnf[j2]=='&')
-    bnf = left + "(" + nt1 + "&" + nt2 + ")&(" + nt3 + "&" + nt4 + ")" + right;
-  
-  else if (j1 && bnf[j1]=='&')
-    bnf = left + nt1 + "&" + nt3 + right;
-  
-  else if (j2 && bnf[j2]=='&')
-    bnf = left + nt1 + "&" + nt2 + right;
+proposition::Formula::Id proposition::CnfConverter::elim_iff(Formula &f, const Formula::Node &node) {
+  if (node.op != Formula::IFF) return f.make(node.op, node.left, node.right);
+  Id to = f.make(Formula::IMPLY, node.left, node.right);
+  Id from = f.make(Formula::IMPLY, node.right, node.left);
+  return f.make(Formula::AND, to, from);
 }
 
-void proposition::CnfConverter::flatten(std::string &bnf) {
-  std::size_t i = 0;
-  while ((i = bnf.find("(", i)) != std::string::npos) {
-    std::size_t j = find_next_term(bnf, i);
-    if ((i > 0 && bnf[i-1] == '&') || (j < bnf.size() && bnf[j] == '&')) { ++i; continue; }
-    bnf.erase(j-1, 1);
-    bnf.erase(i, 1);
+proposition::Formula::Id proposition::CnfConverter::elim_imply(Formula &f, const Formula::Node &node) {
+  if (node.op != Formula::IMPLY) return f.make(node.op, node.left, node.right);
+  return f.make(Formula::OR, f.make(Formula::NOT, node.left), node.right);
+}
+
+proposition::Formula::Id proposition::CnfConverter::reduce_negation(Formula &f, const Formula::Node &node) {
+  if (node.op == Formula::NOT && f[node.left].op == Formula::NOT) return f[node.left].left;
+  return f.make(node.op, node.left, node.right);
+}
+
+// pushes the negations down to the variables. Both polarities of a node are
+// made, memo[2n+1] is the negation of n
+proposition::Formula::Id proposition::CnfConverter::de_morgan(Formula &f, const Id &root) {
+  std::vector<bool> seen;
+  std::vector<Id> order, memo(2*f.size(), -1);
+  f.postorder(root, seen, order);
+  for (const Id &n : order) {
+    Formula::Node node = f[n];
+    if (node.op == Formula::VAR) {
+      memo[2*n] = n;
+      memo[2*n+1] = f.make(Formula::NOT, n);
+    }
+    else if (node.op == Formula::NOT) {
+      memo[2*n] = memo[2*node.left+1];
+      memo[2*n+1] = memo[2*node.left];
+    }
+    else {
+      assert(node.op == Formula::AND || node.op == Formula::OR);
+      Formula::Op dual = node.op == Formula::AND ? Formula::OR : Formula::AND;
+      memo[2*n] = f.make(node.op, memo[2*node.left], memo[2*node.right]);
+      memo[2*n+1] = f.make(dual, memo[2*node.left+1], memo[2*node.right+1]);
+    }
   }
-  
-  i = 0;
-  while ((i = bnf.find("(", i)) != std::string::npos) {
-    if (bnf[i+1] != '(') { ++i; continue; }
-    std::size_t j = find_next_term(bnf, i);
-    bnf.erase(j-1, 1);
-    bnf.erase(i, 1);
-  }
-}
-
-bool proposition::CnfConverter::isvalid(const std::string &bnf, std::size_t i, std::size_t k) {
-  while (i < k && bnf[i] == '!') ++i;
-  if (!isliteral(bnf, i)) {
-    if (i >= k || bnf[i] != '(') return false;
-    std::size_t x = find_next_term(bnf, i);
-    if (x > bnf.size()) return false;
-    if (!isvalid(bnf, i+1, x-1)) return false;
-    i = x;
-  }
-  while (i != k) {
-    if (!isop(bnf, i)) return false;
-    while (i < k && bnf[i] == '!') ++i;
-    if (!isliteral(bnf, i)) {
-      if (i >= k || bnf[i] != '(') return false;
-      std::size_t x = find_next_term(bnf, i);
-      if (x > bnf.size()) return false;
-      if (!isvalid(bnf, i+1, x-1)) return false;
-      i = x;
+  return memo[2*root];
+}
+
+// distributes | over & in a formula of only &, | and literals
+proposition::Formula::Id proposition::CnfConverter::distribution(Formula &f, const Id &root) {
+  std::vector<bool> seen;
+  std::vector<Id> order, memo(f.size(), -1);
+  std::unordered_map<uint64_t, Id> pairs;
+  f.postorder(root, seen, order);
+  for (const Id &n : order) {
+    Formula::Node node = f[n];
+    if (node.op == Formula::AND) memo[n] = f.make(Formula::AND, memo[node.left], memo[node.right]);
+    else if (node.op == Formula::OR) memo[n] = disjoin(f, memo[node.left], memo[node.right], pairs);
+    else memo[n] = n;
+  }
+  return memo[root];
+}
+
+// a | b of two formulas in cnf, as a formula in cnf. A pair whose operand is
+// an & splits into two pairs, it is pushed again with done set once they are
+// pushed, so a long chain of & fits the stack
+proposition::Formula::Id proposition::CnfConverter::disjoin(Formula &f, const Id &a, const Id &b, std::unordered_map<uint64_t, Id> &pairs) {
+  auto key = [](const Id &x, const Id &y) { return uint64_t(x) << 32 | uint32_t(y); };
+  std::vector<std::pair<uint64_t, bool>> stack(1, std::make_pair(key(a, b), false));
+  while (!stack.empty()) {
+    uint64_t k = stack.back().first;
+    bool done = stack.back().second;
+    stack.pop_back();
+    if (!done && pairs.count(k)) continue;
+    
+    Id x = Id(k >> 32), y = Id(uint32_t(k));
+    Formula::Node nx = f[x], ny = f[y];
+    uint64_t left, right;
+    if (nx.op == Formula::AND) left = key(nx.left, y), right = key(nx.right, y);
+    else if (ny.op == Formula::AND) left = key(x, ny.left), right = key(x, ny.right);
+    else {
+      pairs[k] = f.make(Formula::OR, x, y);
+      continue;
     }
+    if (done) {
+      pairs[k] = f.make(Formula::AND, pairs[left], pairs[right]);
+      continue;
+    }
+    stack.emplace_back(k, true);
+    stack.emplace_back(right, false);
+    stack.emplace_back(left, false);
   }
-  return true;
+  return pairs[key(a, b)];
+}
+
+// the clauses of a formula in cnf from left to right, a shared subformula is
+// only taken once
+void proposition::CnfConverter::conjuncts(const Formula &f, const Id &n, std::vector<Id> &out) {
+  std::vector<bool> seen(f.size(), false);
+  std::vector<Id> stack(1, n);
+  while (!stack.empty()) {
+    Id k = stack.back();
+    stack.pop_back();
+    if (seen[k]) continue;
+    seen[k] = true;
+    if (f[k].op != Formula::AND) {
+      out.push_back(k);
+      continue;
+    }
+    stack.push_back(f[k].right);
+    stack.push_back(f[k].left);
+  }
+}
+
+namespace {
+
+// literals of a clause from left to right
+void literals(const proposition::Formula &f, const proposition::Formula::Id &n, std::vector<proposition::Formula::Id> &out) {
+  std::vector<proposition::Formula::Id> stack(1, n);
+  while (!stack.empty()) {
+    proposition::Formula::Id k = stack.back();
+    stack.pop_back();
+    if (f[k].op != proposition::Formula::OR) {
+      out.push_back(k);
+      continue;
+    }
+    stack.push_back(f[k].right);
+    stack.push_back(f[k].left);
+  }
+}
+
+}
+
+void proposition::CnfConverter::flatten(std::ostream &os, const Formula &f, const std::vector<Id> &cnf) {
+  std::vector<Id> lits;
+  for (std::size_t k = 0; k < cnf.size(); ++k) {
+    lits.clear();
+    literals(f, cnf[k], lits);
+    bool paren = cnf.size() > 1 && lits.size() > 1;
+    os << (k ? "&" : "") << (paren ? "(" : "");
+    for (std::size_t i = 0; i < lits.size(); ++i) {
+      os << (i ? "|" : "");
+      f.print(os, lits[i], false);
+    }
+    os << (paren ? ")" : "");
+  }
+  os << "\n";
 }
 
-void proposition::CnfConverter::solve(std::string &bnf) {
+bool proposition::CnfConverter::solve(const std::string &bnf, Clauses &clauses) {
+  Formula f(clauses.symbols);
+  Id root = f.parse(bnf);
+  if (root < 0) return false;
+  
+  // the steps are only printed in verbose mode, a large formula is not
+  // rendered otherwise
+  bool show = verbose.rdbuf();
+  auto step = [&](const char *title, const bool &grouped) {
+    if (!show) return;
+    verbose << title << "\n";
+    f.print(verbose, root, grouped);
+    verbose << "\n";
+  };
   verbose << "----------------------------------------\n" << bnf << "\n";
-  reduce_parenthesis(bnf);
-  verbose << "step 0.1: preprocess, remove redundant parenthesis\n" << bnf << "\n";
-  group(bnf);
-  verbose << "step 0.2: preprocess, grouping\n" << bnf << "\n";
-  elim_iff(bnf);
-  verbose << "step 1: eliminate <=>\n" << bnf << "\n";
-  elim_imply(bnf);
-  verbose << "step 2: eliminate =>\n" << bnf << "\n";
-  reduce_negation(bnf);
-  verbose << "step 3.1: replace !!A with A\n" << bnf << "\n";
-  de_morgan(bnf);
-  verbose << "step 3.2: de morgan's law\n" << bnf << "\n";
-  distribution(bnf);
-  verbose << "step 4: distribution\n" << bnf << "\n";
-  flatten(bnf);
-  verbose << "step 5: flatten formula\n" << bnf << "\n";
-}
-
-void proposition::CnfConverter::extract_literals(const std::string &cnf, Clauses &clauses) {
-  std::size_t i = 0, j = 0;
-  if (cnf.find("&") == std::string::npos) {
-    clauses.push_back({});
-    while (i < cnf.size()) {
-      j = find_next_term(cnf, i);
-      bool neg = cnf[i] == '!';
-      std::string literal = neg ? cnf.substr(i+1, j-i-1) : cnf.substr(i, j-i);
-      // remove A | !A clauses
-      if (clauses.back().find(literal) != clauses.back().end() && clauses.back().at(literal) != neg) {
-        clauses.pop_back();
-        break;
-      }
-      clauses.back()[literal] = neg;
-      i = j+1;
-    }
-  }
-  else {
-    while (i != std::string::npos) {
-      i += i!=0;
-      clauses.push_back({});
-      if (cnf[i] != '(') {
-        j = find_next_term(cnf, i);
-        bool neg = cnf[i] == '!';
-        std::string literal = neg ? cnf.substr(i+1, j-i-1) : cnf.substr(i, j-i);
-        clauses.back()[literal] = neg;
-      }
-      else {
-        while (cnf[i] != ')') {
-          j = find_next_term(cnf, ++i);
-          bool neg = cnf[i] == '!';
-          std::string literal = neg ? cnf.substr(i+1, j-i-1) : cnf.substr(i, j-i);
-          // remove A | !A clauses
-          if (clauses.back().find(literal) != clauses.back().end() && clauses.back().at(literal) != neg) {
-            clauses.pop_back();
-            break;
-          }
-          clauses.back()[literal] = neg;
-          i = j;
-        }
-      }
-      i = cnf.find("&", i);
+  step("step 0.1: preprocess, remove redundant parenthesis", false);
+  step("step 0.2: preprocess, grouping", true);
+  
+  root = rewrite(f, root, elim_iff);
+  step("step 1: eliminate <=>", true);
+  root = rewrite(f, root, elim_imply);
+  step("step 2: eliminate =>", true);
+  root = rewrite(f, root, reduce_negation);
+  step("step 3.1: replace !!A with A", true);
+  root = de_morgan(f, root);
+  step("step 3.2: de morgan's law", true);
+  root = distribution(f, root);
+  step("step 4: distribution", true);
+  
+  std::vector<Id> cnf, lits;
+  conjuncts(f, root, cnf);
+  if (show) {
+    verbose << "step 5: flatten formula\n";
+    flatten(verbose, f, cnf);
+  }
+  
+  std::vector<Literal> line;
+  for (const Id &c : cnf) {
+    lits.clear();
+    literals(f, c, lits);
+    line.clear();
+    for (const Id &k : lits) {
+      line.push_back(f[k].op == Formula::VAR ? 2*f[k].left : 2*f[f[k].left].left + 1);
     }
+    clause(clauses, line);
   }
+  return true;
 }
 
-void proposition::DPLL::update(Clauses &clauses, const std::string literal, const bool val) {
-  for (auto it = clauses.begin(); it != clauses.end(); ++it) {
-    if (it->find(literal) == it->end()) continue;
-    if (val != it->at(literal)) it = std::prev(clauses.erase(it));
-    else it->erase(literal);
-    if (it->empty()) {
-      verbose << (val ? "!" : "") << literal << " contradiction\n\n";
+// adds the clause unless it has a literal and its negation
+void proposition::CnfConverter::clause(Clauses &clauses, const std::vector<Literal> &lits) {
+  clauses.open();
+  for (const Literal &p : lits) {
+    if (clauses.clashes(p)) {
+      clauses.pop();
       return;
     }
+    clauses.push(p);
   }
-  verbose << clauses << "\n";
 }
 
-bool proposition::DPLL::unit_clause(Clauses &clauses, Assignment &asgmt) {
-  for (const auto &clause : clauses) {
-    if (clause.size() == 1) {
-      const std::string &literal = clause.begin()->first;
-      const bool &polarity = clause.begin()->second;
-      asgmt[literal] = !polarity;
-      verbose << "easy case(unit clause): " << literal << "=" << (!polarity ? "true" : "false") << "\n";
-      update(clauses, literal, !polarity);
-      return true;
+// literal equivalent to the subformula n, a shared subformula gets one variable
+proposition::Literal proposition::CnfConverter::encode(const Formula &f, const Id &n, std::vector<bool> &seen, std::vector<Literal> &memo, Clauses &clauses) {
+  std::vector<Id> order;
+  f.postorder(n, seen, order);
+  for (const Id &k : order) {
+    const Formula::Node &node = f[k];
+    if (node.op == Formula::VAR) {
+      memo[k] = 2*node.left;
+      continue;
+    }
+    if (node.op == Formula::NOT) {
+      memo[k] = memo[node.left] ^ 1;
+      continue;
+    }
+    
+    Literal a = memo[node.left];
+    Literal b = memo[node.right];
+    Literal t = memo[k] = 2*clauses.symbols->fresh();
+    if (node.op == Formula::AND) {
+      clause(clauses, {t^1, a});
+      clause(clauses, {t^1, b});
+      clause(clauses, {t, a^1, b^1});
+    }
+    else if (node.op == Formula::OR) {
+      clause(clauses, {t^1, a, b});
+      clause(clauses, {t, a^1});
+      clause(clauses, {t, b^1});
+    }
+    else if (node.op == Formula::IMPLY) {
+      clause(clauses, {t^1, a^1, b});
+      clause(clauses, {t, a});
+      clause(clauses, {t, b^1});
+    }
+    else {
+      clause(clauses, {t^1, a^1, b});
+      clause(clauses, {t^1, a, b^1});
+      clause(clauses, {t, a, b});
+      clause(clauses, {t, a^1, b^1});
     }
   }
-  return false;
+  return memo[n];
 }
 
-bool proposition::DPLL::pure_literal(Clauses &clauses, Assignment &asgmt) {
-  for (auto &p : asgmt) {
-    if (p.second != unbound) continue;
-    const std::string &literal = p.first;
+// the formula must hold, its top level & and the | under them need no
+// variable, nested | share one clause
+void proposition::CnfConverter::assert_true(const Formula &f, const Id &root, Clauses &clauses) {
+  std::vector<bool> seen;
+  std::vector<Literal> memo(f.size(), -1), lits;
+  auto strip = [&f](Id n) -> Id {
+    while (f[n].op == Formula::NOT && f[f[n].left].op == Formula::NOT) n = f[f[n].left].left;
+    return n;
+  };
+  
+  std::vector<Id> conjuncts(1, root), disjuncts;
+  while (!conjuncts.empty()) {
+    Id n = strip(conjuncts.back());
+    conjuncts.pop_back();
+    if (f[n].op == Formula::AND) {
+      conjuncts.push_back(f[n].right);
+      conjuncts.push_back(f[n].left);
+      continue;
+    }
     
-    bool found = true;
-    int8_t polarity = unbound;
-    for (const auto &clause : clauses) {
-      if (clause.find(literal) == clause.end()) continue;
-      if (polarity == unbound) {
-        polarity = clause.at(literal);
-      }
-      else if (polarity != clause.at(literal)) {
-        found = false;
-        break;
+    lits.clear();
+    disjuncts.assign(1, n);
+    while (!disjuncts.empty()) {
+      Id k = strip(disjuncts.back());
+      disjuncts.pop_back();
+      if (f[k].op == Formula::OR) {
+        disjuncts.push_back(f[k].right);
+        disjuncts.push_back(f[k].left);
       }
+      else lits.push_back(encode(f, k, seen, memo, clauses));
     }
-    
-    if (found && polarity != unbound) {
-      p.second = !polarity;
-      verbose << "easy case(pure literal): " << p.first << "=" << (p.second ? "true" : "false") << "\n";
-      update(clauses, p.first, p.second);
+    clause(clauses, lits);
+  }
+}
+
+bool proposition::CnfConverter::tseitin(const std::string &bnf, Clauses &clauses) {
+  Formula f(clauses.symbols);
+  Id root = f.parse(bnf);
+  if (root < 0) return false;
+  verbose << "----------------------------------------\n" << bnf << "\n";
+  
+  // the clauses of the line go straight to the end of the arena, they are
+  // only printed back in verbose mode
+  std::size_t from = clauses.data().size();
+  assert_true(f, root, clauses);
+  if (verbose.rdbuf()) {
+    verbose << "step 1: tseitin encoding, one variable per operator\n";
+    print(verbose, clauses, from);
+  }
+  return true;
+}
+
+// makes p true, drops the clauses it satisfies and its negation from the rest
+// by compacting the arena in place
+void proposition::DPLL::update(Clauses &clauses, const Literal &p) {
+  std::vector<Literal> &arena = clauses.arena;
+  bool contradiction = false;
+  std::size_t i = 0, j = 0;
+  while (i < arena.size()) {
+    Literal *first = &arena[i+1], *last = first + arena[i];
+    i += arena[i]+1;
+    if (std::find(first, last, p) != last) continue;
+    std::size_t header = j++;
+    for (Literal *q = first; q != last; ++q) {
+      if (*q != (p^1)) arena[j++] = *q;
+    }
+    arena[header] = j-header-1;
+    contradiction |= arena[header] == 0;
+  }
+  arena.resize(j);
+  
+  if (contradiction) verbose << (p&1 ? "" : "!") << clauses.symbols->name(p >> 1) << " contradiction\n\n";
+  else verbose << clauses << "\n";
+}
+
+bool proposition::DPLL::unit_clause(Clauses &clauses, Values &values) {
+  const std::vector<Literal> &arena = clauses.arena;
+  for (std::size_t i = 0; i < arena.size(); i += arena[i]+1) {
+    if (arena[i] == 1) {
+      Literal p = arena[i+1];
+      values[p >> 1] = !(p&1);
+      verbose << "easy case(unit clause): " << clauses.symbols->name(p >> 1) << "=" << (!(p&1) ? "true" : "false") << "\n";
+      update(clauses, p);
       return true;
     }
   }
   return false;
 }
 
-bool proposition::DPLL::dpll(Clauses &clauses, Assignment &asgmt) {
-  static const auto isempty = [](const Clause &c) -> bool { return c.empty(); };
+bool proposition::DPLL::pure_literal(Clauses &clauses, Values &values, const std::vector<int32_t> &order) {
+  // bit 1 for a positive occurrence, bit 2 for a negative one
+  std::vector<uint8_t> polarity(values.size(), 0);
+  const std::vector<Literal> &arena = clauses.arena;
+  for (std::size_t i = 0; i < arena.size(); i += arena[i]+1) {
+    for (std::size_t k = i+1; k <= i+arena[i]; ++k)
+      polarity[arena[k] >> 1] |= 1 << (arena[k]&1);
+  }
+  
+  for (const int32_t &v : order) {
+    if (values[v] != unbound) continue;
+    if (polarity[v] != 1 && polarity[v] != 2) continue;
+    values[v] = polarity[v] == 1;
+    verbose << "easy case(pure literal): " << clauses.symbols->name(v) << "=" << (values[v] ? "true" : "false") << "\n";
+    update(clauses, 2*v + !values[v]);
+    return true;
+  }
+  return false;
+}
 
+bool proposition::DPLL::dpll(Clauses &clauses, Values &values, const std::vector<int32_t> &order) {
+  const std::vector<Literal> &arena = clauses.arena;
+  
   while (true) {
-    if (clauses.empty()) {
-      for (auto &p : asgmt) {
-        if (p.second == unbound) {
-          p.second = false;
-          verbose << "unbound: " << p.first << "=false\n";
+    if (arena.empty()) {
+      for (const int32_t &v : order) {
+        if (values[v] == unbound) {
+          values[v] = false;
+          verbose << "unbound: " << clauses.symbols->name(v) << "=false\n";
         }
       }
       verbose << "\n";
       return true;
     }
-    else if (std::find_if(clauses.begin(), clauses.end(), isempty) != clauses.end()) return false;
-    else if (unit_clause(clauses, asgmt));
-    else if (pure_literal(clauses, asgmt));
+    
+    bool empty = false;
+    for (std::size_t i = 0; i < arena.size() && !empty; i += arena[i]+1) empty = arena[i] == 0;
+    if (empty) return false;
+    else if (unit_clause(clauses, values));
+    else if (pure_literal(clauses, values, order));
     else break;
   }
-
-  auto it = std::find_if(asgmt.begin(), asgmt.end(), [](const std::pair<std::string, int8_t> &a) -> bool {
-    return a.second == unbound;
+  
+  int32_t v = *std::find_if(order.begin(), order.end(), [&values](const int32_t &u) -> bool {
+    return values[u] == unbound;
   });
-
+  const std::string &name = clauses.symbols->name(v);
+  
   {
-    it->second = true;
+    values[v] = true;
     Clauses clauses_c = clauses;
-    Assignment asgmt_c = asgmt;
-    verbose << "hard case: guess " << it->first << "=true\n";
-    update(clauses_c, it->first, true);
-    if (dpll(clauses_c, asgmt_c)) {
-      asgmt = std::move(asgmt_c);
+    Values values_c = values;
+    verbose << "hard case: guess " << name << "=true\n";
+    update(clauses_c, 2*v);
+    if (dpll(clauses_c, values_c, order)) {
+      values = std::move(values_c);
       return true;
     }
   }
-
-  it->second = false;
-  verbose << "hard case failed, try: " << it->first << "=false\n";
-  update(clauses, it->first, false);
-  return dpll(clauses, asgmt);
+  
+  values[v] = false;
+  verbose << "hard case failed, try: " << name << "=false\n";
+  update(clauses, 2*v+1);
+  return dpll(clauses, values, order);
 }
 
-bool proposition::DPLL::solve(Clauses &clauses, Assignment &asgmt) {
-  for (auto &clause : clauses) {
-    for (auto &literal : clause) {
-      asgmt[literal.first] = unbound;
-    }
+bool proposition::DPLL::solve(const Clauses &clauses, Assignment &asgmt) {
+  // only the variables that are left in some clause are part of the answer
+  Values values(clauses.symbols->size(), unbound);
+  std::vector<bool> used(values.size(), false);
+  for (std::size_t i = 0; i < clauses.arena.size(); i += clauses.arena[i]+1) {
+    for (std::size_t k = i+1; k <= i+clauses.arena[i]; ++k) used[clauses.arena[k] >> 1] = true;
   }
-  return dpll(clauses, asgmt);
-}
\ No newline at end of file
+  std::vector<int32_t> order;
+  for (const int32_t &v : clauses.symbols->sorted()) {
+    if (used[v]) order.push_back(v);
+  }
+  
+  // the branches copy the arena only
+  Clauses working;
+  working.arena = clauses.arena;
+  working.symbols = clauses.symbols;
+  if (!dpll(working, values, order)) return false;
+  for (const int32_t &v : order) {
+    if (!clauses.symbols->hidden(v)) asgmt[clauses.symbols->name(v)] = values[v];
+  }
+  return true;
+}
@@ -4,63 +4,204 @@
 #pragma once
 #include <iostream>
 #include <string>
-#include <list>
 #include <map>
+#include <vector>
+#include <memory>
+#include <cstdint>
 #include <unordered_map>
 
 namespace proposition {
 
 typedef std::map<std::string, int8_t> Assignment;
-typedef std::unordered_map<std::string, bool> Clause;
-typedef std::list<Clause> Clauses;
+
+// variable v is the literal 2v and its negation 2v+1
+typedef int32_t Literal;
 
 extern const int8_t unbound;
 extern std::ostream verbose;
 
-class CnfConverter {
+// variable names, interned to dense ids once at load time
+class Symbols {
 private:
-  static bool isliteral(const std::string &bnf, std::size_t &i);
+  std::vector<std::string> names;
+  std::unordered_map<std::string, int32_t> ids;
+  std::vector<bool> aux;
+  std::size_t made;  // auxiliary variables so far
+  
+public:
+  Symbols() : made(0) {}
   
-  static bool isop(const std::string &bnf, std::size_t &i);
+  void reserve(const std::size_t &n);
   
-  static std::size_t find_next_term(const std::string &bnf, std::size_t i);
+  int32_t intern(const std::string &name);
   
-  static void group(std::string &bnf, const std::size_t &i);
+  // a new auxiliary variable, its name `@k` can not clash with an input name
+  // and it is left out of the printed assignment
+  int32_t fresh();
   
-  static void elim_iff(std::string &bnf, const std::size_t &i);
+  bool hidden(const int32_t &v) const { return aux[v]; }
   
-  static void elim_imply(std::string &bnf, const std::size_t &i);
+  const std::string& name(const int32_t &v) const { return names[v]; }
   
-  static void reduce_negation(std::string &bnf);
+  std::size_t size() const { return names.size(); }
   
-  static void de_morgan(std::string &bnf);
+  // ids in name order
+  std::vector<int32_t> sorted() const;
+};
+
+// every clause lives in one arena of literals, a header word with the size of
+// the clause followed by its literals. The symbols are shared by all copies
+class Clauses {
+private:
+  friend class DPLL;
   
-  static void reduce_parenthesis(std::string &bnf);
+  static const int32_t scan = 8;
   
-  static void distribution(std::string &bnf, const std::size_t &i);
+  std::vector<Literal> arena;
+  std::size_t last;  // header of the clause being built
+  std::vector<std::size_t> where;  // arena index of a variable in that clause
   
-  static void flatten(std::string &bnf);
+  std::size_t find(const int32_t &v) const;
   
 public:
-  static bool isvalid(const std::string &bnf, std::size_t i, std::size_t k);
+  std::shared_ptr<Symbols> symbols;
   
-  static void solve(std::string &bnf);
+  Clauses() : last(-1), symbols(std::make_shared<Symbols>()) {}
   
-  static void extract_literals(const std::string &cnf, Clauses &clauses);
+  // starts a new, empty clause
+  void open();
+  
+  // adds a literal to the last clause, it replaces the literal of the same
+  // variable if there is one
+  void push(const Literal &p);
+  
+  // whether the last clause has the negation of p
+  bool clashes(const Literal &p) const;
+  
+  // removes the last clause
+  void pop();
+  
+  const std::vector<Literal>& data() const { return arena; }
+};
+
+// formulas of one line as a DAG in one arena of nodes. Nodes are hash-consed,
+// a subformula that occurs twice is one node, so a rewrite that remembers its
+// result per node visits every distinct subformula once
+class Formula {
+public:
+  typedef int32_t Id;
+  
+  // binary operators in order of decreasing precedence
+  enum Op : uint8_t { VAR, NOT, AND, OR, IMPLY, IFF };
+  
+  // a VAR keeps its variable in left, a NOT its operand
+  struct Node {
+    Op op;
+    Id left, right;
+    
+    bool operator==(const Node &other) const {
+      return op == other.op && left == other.left && right == other.right;
+    }
+  };
+  
+private:
+  struct Hash {
+    std::size_t operator()(const Node &node) const {
+      return (std::size_t(node.left) * 0x9e3779b97f4a7c15ULL) ^ (std::size_t(node.right) << 3) ^ node.op;
+    }
+  };
+  
+  // a variable is 'a', `=>` is '=' and `<=>` is '<', the last token is 0
+  struct Token {
+    char kind;
+    int32_t var;
+  };
+  
+  std::vector<Node> nodes;
+  std::unordered_map<Node, Id, Hash> table;
+  
+  bool tokenize(const std::string &bnf, std::vector<Token> &tokens);
+  
+public:
+  std::shared_ptr<Symbols> symbols;
+  
+  explicit Formula(const std::shared_ptr<Symbols> &symbols) : symbols(symbols) {}
+  
+  static int precedence(const Op &op);
+  
+  // the node for op over its operands, an existing one if it was made before
+  Id make(const Op &op, const Id &left, const Id &right = -1);
+  
+  // the root of a line, -1 if it is not a well-formed sentence
+  Id parse(const std::string &bnf);
+  
+  // appends the nodes under n that are not seen yet, every node after its
+  // operands, without recursion so a long chain of operators fits the stack
+  void postorder(const Id &n, std::vector<bool> &seen, std::vector<Id> &order) const;
+  
+  const Node& operator[](const Id &n) const { return nodes[n]; }
+  
+  std::size_t size() const { return nodes.size(); }
+  
+  // grouped puts every binary operand in parenthesis, otherwise only the
+  // ones that need them are
+  void print(std::ostream &os, const Id &n, const bool &grouped) const;
+};
+
+class CnfConverter {
+private:
+  typedef Formula::Id Id;
+  
+  // rebuilds the formula bottom up, rule makes a node from one whose operands
+  // are rewritten already
+  static Id rewrite(Formula &f, const Id &root, Id (*rule)(Formula &, const Formula::Node &));
+  
+  static Id elim_iff(Formula &f, const Formula::Node &node);
+  
+  static Id elim_imply(Formula &f, const Formula::Node &node);
+  
+  static Id reduce_negation(Formula &f, const Formula::Node &node);
+  
+  static Id de_morgan(Formula &f, const Id &root);
+  
+  static Id distribution(Formula &f, const Id &root);
+  
+  static Id disjoin(Formula &f, const Id &a, const Id &b, std::unordered_map<uint64_t, Id> &pairs);
+  
+  static void conjuncts(const Formula &f, const Id &n, std::vector<Id> &out);
+  
+  static void flatten(std::ostream &os, const Formula &f, const std::vector<Id> &cnf);
+  
+  static void clause(Clauses &clauses, const std::vector<Literal> &lits);
+  
+  static Literal encode(const Formula &f, const Id &n, std::vector<bool> &seen, std::vector<Literal> &memo, Clauses &clauses);
+  
+  static void assert_true(const Formula &f, const Id &root, Clauses &clauses);
+  
+public:
+  // converts one line by rewriting its formula, false if it is not parseable
+  static bool solve(const std::string &bnf, Clauses &clauses);
+  
+  // Tseitin encoding, every operator gets an auxiliary variable equivalent to
+  // its subformula, so the clauses grow linearly with the formula
+  static bool tseitin(const std::string &bnf, Clauses &clauses);
 };
 
 class DPLL {
 private:
-  static void update(Clauses &clauses, const std::string literal, const bool val);
+  // value of every variable, indexed by id
+  typedef std::vector<int8_t> Values;
+  
+  static void update(Clauses &clauses, const Literal &p);
   
-  static bool unit_clause(Clauses &clauses, Assignment &asgmt);
+  static bool unit_clause(Clauses &clauses, Values &values);
   
-  static bool pure_literal(Clauses &clauses, Assignment &asgmt);
+  static bool pure_literal(Clauses &clauses, Values &values, const std::vector<int32_t> &order);
   
-  static bool dpll(Clauses &clauses, Assignment &asgmt);
+  static bool dpll(Clauses &clauses, Values &values, const std::vector<int32_t> &order);
   
 public:
-  static bool solve(Clauses &clauses, Assignment &asgmt);
+  static bool solve(const Clauses &clauses, Assignment &asgmt);
 };
 
 }